@@ -0,0 +1,71 @@
+#include "Arduino.h"
+#include "AmbientLight.h"
+
+AmbientLight::AmbientLight(uint8_t adcChannel, uint16_t darkLevel, uint16_t brightLevel) {
+  this->adcChannel = adcChannel;
+  this->darkLevel = darkLevel;
+  this->brightLevel = max(brightLevel, darkLevel + 1);
+
+  started = false;
+  firstReading = true;
+  filteredLevel = 0;
+  lightLevel = 0;
+}
+
+void AmbientLight::begin() {
+  if (!started) {
+    firstReading = true;
+
+    // AVcc reference, selected channel, single conversions without interrupts, 125 kHz ADC clock
+    ADMUX = _BV(REFS0) | (adcChannel & 0x07);
+    ADCSRB = 0;
+    ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADIF) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+    started = true;
+  }
+}
+
+void AmbientLight::end() {
+  if (started) {
+    ADCSRA &= ~_BV(ADEN);
+    started = false;
+  }
+}
+
+void AmbientLight::update() {
+  // Take the conversion started by the previous update (it finished long ago, ~104 us after it started), then start the next one
+  if (started && (ADCSRA & _BV(ADSC)) == 0) {
+    uint16_t reading = ADC;
+    ADCSRA |= _BV(ADSC);
+
+    // IIR filter (the filtered value keeps 4 extra bits of precision)
+    if (firstReading) {
+      filteredLevel = reading << 4;
+      lightLevel = reading;
+      firstReading = false;
+    } else {
+      int16_t delta = static_cast<int16_t>(reading << 4) - static_cast<int16_t>(filteredLevel);
+      filteredLevel += delta >> AMBIENT_LIGHT_FILTER_SHIFT;
+    }
+
+    // Only follow the filtered value once it has moved far enough away from the current light level
+    uint16_t level = filteredLevel >> 4;
+    uint16_t difference = level > lightLevel ? level - lightLevel : lightLevel - level;
+    if (difference > AMBIENT_LIGHT_HYSTERESIS) {
+      lightLevel = level;
+    }
+  }
+}
+
+uint16_t AmbientLight::getLightLevel() const {
+  return lightLevel;
+}
+
+uint8_t AmbientLight::getBrightness(uint8_t minBrightness, uint8_t maxBrightness) const {
+  if (lightLevel <= darkLevel || maxBrightness <= minBrightness) {
+    return minBrightness;
+  } else if (lightLevel >= brightLevel) {
+    return maxBrightness;
+  }
+  uint32_t scaled = static_cast<uint32_t>(lightLevel - darkLevel) * (maxBrightness - minBrightness) / (brightLevel - darkLevel);
+  return minBrightness + static_cast<uint8_t>(scaled);
+}
@@ -0,0 +1,66 @@
+#ifndef AMBIENT_LIGHT_H
+#define AMBIENT_LIGHT_H
+
+#include "Arduino.h"
+
+// The IIR filter coefficient, as a power of 2 (each new reading contributes 1 / 2^n of the filtered value)
+const uint8_t AMBIENT_LIGHT_FILTER_SHIFT = 4;
+
+// The amount (in ADC units) by which the filtered light level must change before the brightness follows it
+const uint16_t AMBIENT_LIGHT_HYSTERESIS = 24;
+
+/**
+ * Photoresistor-based ambient light sensor.
+ * Each update() takes the single conversion started by the previous one and starts the next, so reading the light level
+ * never blocks, and the ADC raises no interrupts (which would stretch the display's cycle counted LED on-times and wake
+ * its idle sleep).
+ */
+class AmbientLight {
+public:
+  /**
+   * @param adcChannel The ADC channel of the light sensor (6 or 7 are unused on the clock board)
+   * @param darkLevel The (filtered) ADC reading at or below which the clock runs at its minimum brightness
+   * @param brightLevel The (filtered) ADC reading at or above which the clock runs at its maximum brightness
+   */
+  AmbientLight(uint8_t adcChannel, uint16_t darkLevel, uint16_t brightLevel);
+
+  /**
+   * Enables the ADC and starts the first conversion (does nothing if already started)
+   */
+  void begin();
+
+  /**
+   * Disables the ADC
+   */
+  void end();
+
+  /**
+   * Feeds the last conversion through the filter and starts the next one
+   */
+  void update();
+
+  /**
+   * Gets the filtered light level (0..1023), with hysteresis applied
+   */
+  uint16_t getLightLevel() const;
+
+  /**
+   * Maps the current light level to a brightness between the given limits
+   *
+   * @param minBrightness The brightness in the dark
+   * @param maxBrightness The brightness in bright light
+   */
+  uint8_t getBrightness(uint8_t minBrightness, uint8_t maxBrightness) const;
+
+private:
+  uint8_t adcChannel;
+  uint16_t darkLevel;
+  uint16_t brightLevel;
+
+  bool started;
+  bool firstReading;
+  uint16_t filteredLevel;
+  uint16_t lightLevel;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "Arduino.h"
+#include <util/atomic.h>
+#include "ButtonInput.h"
+#include "ClockTime.h"
+#include "InputReplay.h"
+
+// Pin change interrupt state (the interrupt is shared by all of PORTB, so this lives outside of the class)
+static uint8_t buttonInputMask = 0;
+static volatile uint8_t debouncedButtons = 0;
+static volatile uint32_t lastEdgeMillis = 0;
+static ButtonEvent buttonEvents[BUTTON_EVENT_QUEUE_LENGTH];
+static volatile uint8_t buttonEventHead = 0;
+static volatile uint8_t buttonEventCount = 0;
+static volatile uint8_t droppedButtonEventCount = 0;
+
+/**
+ * Gets the buttons currently pressed (replayed inputs in virtual time builds)
+ */
+static inline uint8_t readPressedButtons() {
+#ifdef CLOCK_VIRTUAL_TIME
+  return ~inputReplay.getButtonPins() & buttonInputMask;
+#else
+  return ~PINB & buttonInputMask;
+#endif
+}
+
+/**
+ * Queues a change of the pressed buttons unless it falls within the debounce lockout (call with interrupts disabled)
+ */
+static void recordButtons(uint8_t pressed, uint32_t currentMillis) {
+  if (pressed != debouncedButtons && currentMillis - lastEdgeMillis >= BUTTON_DEBOUNCE_MS) {
+    debouncedButtons = pressed;
+    lastEdgeMillis = currentMillis;
+    if (buttonEventCount < BUTTON_EVENT_QUEUE_LENGTH) {
+      ButtonEvent &event = buttonEvents[(buttonEventHead + buttonEventCount) & (BUTTON_EVENT_QUEUE_LENGTH - 1)];
+      event.millis = currentMillis;
+      event.pressed = pressed;
+      ++buttonEventCount;
+    } else if (droppedButtonEventCount < 255) {
+      ++droppedButtonEventCount;
+    }
+  }
+}
+
+#ifndef CLOCK_VIRTUAL_TIME
+ISR(PCINT0_vect) {
+  recordButtons(readPressedButtons(), clockMillis());
+}
+#endif
+
+
+ButtonInput::ButtonInput(uint8_t buttonMask) {
+  this->buttonMask = buttonMask;
+}
+
+void ButtonInput::begin() {
+  DDRB &= ~buttonMask;
+  PORTB |= buttonMask;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    buttonInputMask = buttonMask;
+    debouncedButtons = 0;
+    lastEdgeMillis = clockMillis() - BUTTON_DEBOUNCE_MS;
+    buttonEventHead = 0;
+    buttonEventCount = 0;
+    droppedButtonEventCount = 0;
+  }
+
+#ifndef CLOCK_VIRTUAL_TIME
+  // Buttons held since before begin() are picked up by the first readEvent()
+  PCMSK0 |= buttonMask;
+  PCIFR = _BV(PCIF0);
+  PCICR |= _BV(PCIE0);
+#endif
+}
+
+bool ButtonInput::readEvent(ButtonEvent &event) {
+  bool eventRead = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    // Pick up changes which happened during the last lockout (and, in virtual time builds, read the replayed buttons)
+    recordButtons(readPressedButtons(), clockMillis());
+
+    if (buttonEventCount > 0) {
+      event = buttonEvents[buttonEventHead];
+      buttonEventHead = (buttonEventHead + 1) & (BUTTON_EVENT_QUEUE_LENGTH - 1);
+      --buttonEventCount;
+      eventRead = true;
+    }
+  }
+  return eventRead;
+}
+
+uint8_t ButtonInput::getDroppedEventCount() const {
+  return droppedButtonEventCount;
+}
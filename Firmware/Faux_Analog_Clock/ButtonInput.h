@@ -0,0 +1,56 @@
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+#include "Arduino.h"
+
+// The number of milliseconds after an accepted edge during which further edges (contact bounce) are ignored
+const uint8_t BUTTON_DEBOUNCE_MS = 50;
+
+// The number of button events which can be queued (must be a power of 2)
+const uint8_t BUTTON_EVENT_QUEUE_LENGTH = 8;
+
+/**
+ * A change of the debounced button state
+ */
+struct ButtonEvent {
+  uint32_t millis;  // When the change happened (clockMillis())
+  uint8_t pressed;  // The PORTB masks of the buttons pressed from then on
+};
+
+/**
+ * Buttons on PORTB, read by the pin change interrupt.
+ * The interrupt timestamps each edge, so presses shorter than the menu task period aren't lost and press lengths don't depend on the frame rate.
+ * An edge is accepted at once and starts a BUTTON_DEBOUNCE_MS lockout; a change which is still there once the lockout is over
+ * (e.g. a release during the lockout) is picked up by readEvent().
+ * The interrupt only reads PINB, so it can't disturb the display's read-modify-write of the other PORTB pins.
+ */
+class ButtonInput {
+public:
+  /**
+   * @param buttonMask The PORTB masks of all buttons (active low, using the internal pull-ups)
+   */
+  ButtonInput(uint8_t buttonMask);
+
+  /**
+   * Sets up the pins and enables the pin change interrupt
+   */
+  void begin();
+
+  /**
+   * Takes the oldest queued button event
+   *
+   * @param event Set to the event
+   * @return false if no event was queued
+   */
+  bool readEvent(ButtonEvent &event);
+
+  /**
+   * Gets the number of events dropped because the queue was full
+   */
+  uint8_t getDroppedEventCount() const;
+
+private:
+  uint8_t buttonMask;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "Arduino.h"
+#include "ClockTime.h"
+#include "FrameBufferView.h"
+#include "ClockAnimation.h"
+
+/**
+ * Applies an easing curve to the progress through a keyframe (both 0..65535)
+ */
+static uint16_t applyEasing(uint16_t progress, uint8_t easing) {
+  uint16_t squared = static_cast<uint16_t>((static_cast<uint32_t>(progress) * progress) >> 16);
+  switch (easing) {
+    case ANIMATION_EASING_IN:
+      return squared;
+    case ANIMATION_EASING_OUT: {
+      uint16_t remaining = 65535 - progress;
+      return 65535 - static_cast<uint16_t>((static_cast<uint32_t>(remaining) * remaining) >> 16);
+    }
+    case ANIMATION_EASING_IN_OUT:
+      // progress^2 * (3 - 2 * progress)
+      return static_cast<uint16_t>((static_cast<uint32_t>(squared) * ((196608UL - 2UL * progress) >> 2)) >> 14);
+    case ANIMATION_EASING_LINEAR:
+    default:
+      return progress;
+  }
+}
+
+ClockAnimation::ClockAnimation(const AnimationTarget *targets, uint8_t targetCount) {
+  this->targets = targets;
+  this->targetCount = min(targetCount, ANIMATION_MAX_TARGETS);
+  script = NULL;
+  startMillis = 0;
+  lengthMilliseconds = 0;
+  usedTargets = 0;
+  drawnTargets = 0;
+}
+
+void ClockAnimation::play(const AnimationScript *script) {
+  if (this->script == script) {
+    return;
+  }
+
+  this->script = script;
+  memcpy_P(&currentScript, script, sizeof(AnimationScript));
+  startMillis = clockMillis();
+
+  // The script is as long as its longest track
+  uint32_t trackLengths[ANIMATION_MAX_TARGETS];
+  memset(trackLengths, 0, sizeof(trackLengths));
+  usedTargets = 0;
+  for (uint8_t i = 0; i < currentScript.keyframeCount; ++i) {
+    AnimationKeyframe keyframe;
+    memcpy_P(&keyframe, currentScript.keyframes + i, sizeof(AnimationKeyframe));
+    if (keyframe.target < targetCount) {
+      trackLengths[keyframe.target] += keyframe.durationMilliseconds;
+      usedTargets |= _BV(keyframe.target);
+    }
+  }
+  lengthMilliseconds = 0;
+  for (uint8_t i = 0; i < targetCount; ++i) {
+    lengthMilliseconds = max(lengthMilliseconds, trackLengths[i]);
+  }
+
+  drawnTargets = 0;
+}
+
+void ClockAnimation::stop() {
+  script = NULL;
+}
+
+bool ClockAnimation::isPlaying() const {
+  return script != NULL;
+}
+
+bool ClockAnimation::isPlaying(const AnimationScript *script) const {
+  return script != NULL && this->script == script;
+}
+
+bool ClockAnimation::update() {
+  if (script == NULL) {
+    return false;
+  }
+
+  uint32_t elapsedMilliseconds = clockMillis() - startMillis;
+  bool ended = false;
+  if (elapsedMilliseconds >= lengthMilliseconds) {
+    if (currentScript.loop && lengthMilliseconds > 0) {
+      elapsedMilliseconds %= lengthMilliseconds;
+    } else {
+      elapsedMilliseconds = lengthMilliseconds;
+      ended = !currentScript.loop;
+    }
+  }
+
+  for (uint8_t i = 0; i < targetCount; ++i) {
+    if ((usedTargets & _BV(i)) != 0) {
+      drawTarget(i, getTrackValue(i, elapsedMilliseconds));
+    }
+  }
+
+  if (ended) {
+    script = NULL;
+  }
+  return !ended;
+}
+
+
+uint8_t ClockAnimation::getTrackValue(uint8_t target, uint32_t elapsedMilliseconds) const {
+  uint8_t value = 0;
+  uint32_t keyframeStart = 0;
+  for (uint8_t i = 0; i < currentScript.keyframeCount; ++i) {
+    AnimationKeyframe keyframe;
+    memcpy_P(&keyframe, currentScript.keyframes + i, sizeof(AnimationKeyframe));
+    if (keyframe.target != target) {
+      continue;
+    }
+
+    // Within this keyframe: ease from the previous value toward this one
+    uint32_t keyframeElapsed = elapsedMilliseconds - keyframeStart;
+    if (elapsedMilliseconds >= keyframeStart && keyframeElapsed < keyframe.durationMilliseconds) {
+      uint16_t progress = applyEasing(static_cast<uint16_t>((keyframeElapsed << 16) / keyframe.durationMilliseconds), keyframe.easing);
+      if (keyframe.value > value) {
+        return value + static_cast<uint8_t>((static_cast<uint32_t>(keyframe.value - value) * progress) >> 16);
+      } else {
+        return value - static_cast<uint8_t>((static_cast<uint32_t>(value - keyframe.value) * progress) >> 16);
+      }
+    }
+
+    value = keyframe.value;
+    keyframeStart += keyframe.durationMilliseconds;
+  }
+  return value;
+}
+
+void ClockAnimation::drawTarget(uint8_t target, uint8_t value) {
+  bool drawn = (drawnTargets & _BV(target)) != 0;
+  if (drawn && lastValues[target] == value) {
+    return;
+  }
+
+  FrameBufferView *view = targets[target].view;
+  if (targets[target].drawMode == ANIMATION_DRAW_DOT) {
+    if (drawn) {
+      view->setValue(lastValues[target], 0);
+    } else {
+      view->setAllValues(0);
+    }
+    view->setValue(value, 255);
+  } else {
+    view->setAllValues(value);
+  }
+
+  lastValues[target] = value;
+  drawnTargets |= _BV(target);
+}
@@ -0,0 +1,135 @@
+#ifndef CLOCK_ANIMATION_H
+#define CLOCK_ANIMATION_H
+
+#include "Arduino.h"
+#include "FrameBufferView.h"
+
+/**
+ * Easing curves, applied to the progress through a keyframe
+ */
+const uint8_t ANIMATION_EASING_LINEAR = 0;
+const uint8_t ANIMATION_EASING_IN = 1;     // Quadratic, starting slowly
+const uint8_t ANIMATION_EASING_OUT = 2;    // Quadratic, ending slowly
+const uint8_t ANIMATION_EASING_IN_OUT = 3; // Smoothstep
+
+/**
+ * How an animated value is drawn into its target's frame buffer view
+ */
+const uint8_t ANIMATION_DRAW_FILL = 0; // Every value of the view is set to the animated value
+const uint8_t ANIMATION_DRAW_DOT = 1;  // The animated value is an index into the view, which has only that LED lit (at full intensity)
+
+/**
+ * The largest number of targets an animation can have
+ */
+const uint8_t ANIMATION_MAX_TARGETS = 8;
+
+/**
+ * Something an animation draws into
+ */
+struct AnimationTarget {
+  // The frame buffer view to draw into
+  FrameBufferView *view;
+
+  // How the value is drawn (see ANIMATION_DRAW_*)
+  uint8_t drawMode;
+};
+
+/**
+ * A keyframe, as stored in a (PROGMEM) keyframe table
+ */
+struct AnimationKeyframe {
+  // The target whose value is animated (an index into the animation's target table)
+  uint8_t target;
+
+  // The value the target reaches at the end of the keyframe
+  uint8_t value;
+
+  // The number of milliseconds it takes to get there from the target's previous keyframe (0 jumps straight to the value)
+  uint16_t durationMilliseconds;
+
+  // The curve the value follows (see ANIMATION_EASING_*)
+  uint8_t easing;
+};
+
+/**
+ * An animation script, as stored in PROGMEM
+ */
+struct AnimationScript {
+  // The keyframes (in PROGMEM)
+  const AnimationKeyframe *keyframes;
+
+  // The number of keyframes
+  uint8_t keyframeCount;
+
+  // If true, the script starts over when it reaches its end; otherwise the targets keep their last values
+  bool loop;
+};
+
+/**
+ * Plays keyframe scripts on a table of frame buffer views.
+ * The keyframes of each target form a track, starting from 0 (or from a keyframe with no duration); all tracks start
+ * together, and a script ends (or loops) when its longest track does.
+ * The values are computed from the time since the script started, so an animation runs at the same speed however often
+ * it's updated, and it never blocks: the caller updates it alongside everything else.
+ */
+class ClockAnimation {
+public:
+  /**
+   * @param targets The target table (keyframe target indices refer to it)
+   * @param targetCount The number of targets in the table (at most ANIMATION_MAX_TARGETS)
+   */
+  ClockAnimation(const AnimationTarget *targets, uint8_t targetCount);
+
+  /**
+   * Starts playing the given script (in PROGMEM), unless it's already playing
+   */
+  void play(const AnimationScript *script);
+
+  /**
+   * Stops playing (the targets keep their current values)
+   */
+  void stop();
+
+  /**
+   * Returns true if a script is playing
+   */
+  bool isPlaying() const;
+
+  /**
+   * Returns true if the given script is playing
+   */
+  bool isPlaying(const AnimationScript *script) const;
+
+  /**
+   * Draws the current values of the playing script into its targets (only those which changed)
+   *
+   * @return true if the script is still playing, false if it isn't (or has just ended)
+   */
+  bool update();
+
+private:
+  const AnimationTarget *targets;
+  uint8_t targetCount;
+
+  const AnimationScript *script;
+  AnimationScript currentScript;
+  uint32_t startMillis;
+  uint32_t lengthMilliseconds;
+
+  // The targets used by the script, and those which have been drawn since it started (one bit per target)
+  uint8_t usedTargets;
+  uint8_t drawnTargets;
+  uint8_t lastValues[ANIMATION_MAX_TARGETS];
+
+  /**
+   * Gets the value of a target's track at the given time into the script
+   */
+  uint8_t getTrackValue(uint8_t target, uint32_t elapsedMilliseconds) const;
+
+  /**
+   * Draws a target's value (if it changed)
+   */
+  void drawTarget(uint8_t target, uint8_t value);
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef CLOCK_BOARD_H
+#define CLOCK_BOARD_H
+
+#include "Arduino.h"
+
+/*
+ * Board description: how the clock display's Charlieplex lines and LEDs are wired.
+ * Everything here is constexpr, so ClockDisplay's scan and its line and LED tables are generated from it at compile time
+ * and a board revision only needs this file changed.
+ * A CharlieplexDisplay<LineCount, Index> is scanned using the CharlieplexBoard<LineCount> specialization (see below), so
+ * a board with more lines adds a specialization of its own.
+ */
+
+/**
+ * I/O ports which can carry Charlieplex lines
+ */
+const uint8_t CLOCK_BOARD_PORT_B = 0;
+const uint8_t CLOCK_BOARD_PORT_C = 1;
+const uint8_t CLOCK_BOARD_PORT_D = 2;
+
+/**
+ * A Charlieplex line: an I/O port and the bit within it
+ */
+struct CharlieplexLine {
+  uint8_t port;
+  uint8_t bit;
+};
+
+/**
+ * The Charlieplex lines, in scan order
+ */
+constexpr CharlieplexLine CLOCK_BOARD_LINES[] = {
+  { CLOCK_BOARD_PORT_D, 0 },
+  { CLOCK_BOARD_PORT_D, 1 },
+  { CLOCK_BOARD_PORT_D, 2 },
+  { CLOCK_BOARD_PORT_D, 3 },
+  { CLOCK_BOARD_PORT_D, 4 },
+  { CLOCK_BOARD_PORT_D, 5 },
+  { CLOCK_BOARD_PORT_D, 6 },
+  { CLOCK_BOARD_PORT_D, 7 },
+  { CLOCK_BOARD_PORT_B, 0 },
+  { CLOCK_BOARD_PORT_B, 1 },
+  { CLOCK_BOARD_PORT_B, 2 },
+  { CLOCK_BOARD_PORT_B, 3 },
+  { CLOCK_BOARD_PORT_C, 0 },
+  { CLOCK_BOARD_PORT_C, 1 }
+};
+
+/**
+ * The number of Charlieplex lines
+ */
+constexpr uint8_t CLOCK_BOARD_LINE_COUNT = sizeof(CLOCK_BOARD_LINES) / sizeof(CLOCK_BOARD_LINES[0]);
+
+/**
+ * The number of LEDs (one for each ordered pair of distinct lines)
+ */
+constexpr uint16_t CLOCK_BOARD_LED_COUNT = static_cast<uint16_t>(CLOCK_BOARD_LINE_COUNT) * (CLOCK_BOARD_LINE_COUNT - 1);
+
+/**
+ * Maps a physical LED to its logical index (its index in the display frame buffer, see the offsets in ClockDisplay.h).
+ * Physical LEDs are numbered in scan order: the LED lit by driving line pos high and line neg low is
+ * pos * (CLOCK_BOARD_LINE_COUNT - 1) + (neg < pos ? neg : neg - 1).
+ * This board is laid out so that the two are the same.
+ */
+constexpr uint16_t clockBoardLogicalLED(uint16_t physicalLED) {
+  return physicalLED;
+}
+
+/**
+ * Returns true if every physical LED (starting from the given one) maps to a logical index within the frame buffer
+ */
+constexpr bool clockBoardLEDMapValid(uint16_t physicalLED = 0) {
+  return physicalLED >= CLOCK_BOARD_LED_COUNT ||
+    (clockBoardLogicalLED(physicalLED) < CLOCK_BOARD_LED_COUNT && clockBoardLEDMapValid(physicalLED + 1));
+}
+
+/**
+ * Returns true if no two lines (starting from the given pair) share a port bit
+ */
+constexpr bool clockBoardLinesDistinct(uint8_t line = 0, uint8_t otherLine = 1) {
+  return line >= CLOCK_BOARD_LINE_COUNT ? true :
+    otherLine >= CLOCK_BOARD_LINE_COUNT ? clockBoardLinesDistinct(line + 1, line + 2) :
+    (CLOCK_BOARD_LINES[line].port != CLOCK_BOARD_LINES[otherLine].port || CLOCK_BOARD_LINES[line].bit != CLOCK_BOARD_LINES[otherLine].bit) &&
+      clockBoardLinesDistinct(line, otherLine + 1);
+}
+
+static_assert(clockBoardLEDMapValid(), "Every physical LED must map to a frame buffer index");
+static_assert(clockBoardLinesDistinct(), "Charlieplex lines must not share a port bit");
+
+/**
+ * The board description used by a Charlieplex display with the given number of lines. Each specialization provides:
+ *   static constexpr CharlieplexLine line(uint8_t index);              The lines, in scan order
+ *   static constexpr uint16_t logicalLED(uint16_t physicalLED);       The physical to logical LED map (see clockBoardLogicalLED())
+ */
+template<uint8_t LineCount>
+struct CharlieplexBoard;
+
+/**
+ * This clock's board
+ */
+template<>
+struct CharlieplexBoard<CLOCK_BOARD_LINE_COUNT> {
+  static constexpr CharlieplexLine line(uint8_t index) {
+    return CLOCK_BOARD_LINES[index];
+  }
+
+  static constexpr uint16_t logicalLED(uint16_t physicalLED) {
+    return clockBoardLogicalLED(physicalLED);
+  }
+};
+
+/**
+ * Gets the mask of the bits of the given port which carry the lines of a Charlieplex board (starting from the given line)
+ */
+template<uint8_t LineCount>
+constexpr uint8_t charlieplexPortMask(uint8_t port, uint8_t line = 0) {
+  return line >= LineCount ? 0 :
+    ((CharlieplexBoard<LineCount>::line(line).port == port ? _BV(CharlieplexBoard<LineCount>::line(line).bit) : 0) |
+      charlieplexPortMask<LineCount>(port, line + 1));
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "Arduino.h"
+#include "FrameBufferView.h"
+#include "ClockDisplay.h"
+#include "ClockCompositor.h"
+
+// Display range covered by each layer: { offset, count }
+const PROGMEM ClockDisplayIndex CLOCK_LAYER_RANGES[CLOCK_LAYER_COUNT][2] = {
+  { CLOCK_SECONDS_OFFSET, CLOCK_DISPLAY_LED_COUNT },                                  // Base
+  { CLOCK_FACE_INNER_OFFSET, CLOCK_7SEG_LEFT_OFFSET - CLOCK_FACE_INNER_OFFSET },     // Face
+  { CLOCK_FACE_INNER_OFFSET, CLOCK_7SEG_LEFT_OFFSET - CLOCK_FACE_INNER_OFFSET },     // Overlay
+  { CLOCK_7SEG_LEFT_OFFSET, CLOCK_DISPLAY_LED_COUNT - CLOCK_7SEG_LEFT_OFFSET }       // Menu
+};
+
+/**
+ * Reads a display index from program memory
+ */
+static inline ClockDisplayIndex readDisplayIndex(const ClockDisplayIndex *address) {
+  return sizeof(ClockDisplayIndex) == 1 ? pgm_read_byte(address) : pgm_read_word(address);
+}
+
+ClockCompositor::ClockCompositor(ClockDisplay &clockDisplay) : clockDisplay(clockDisplay) {
+  for (uint8_t i = 0; i < CLOCK_LAYER_COUNT; ++i) {
+    Layer &layer = layers[i];
+    layer.offset = readDisplayIndex(&CLOCK_LAYER_RANGES[i][0]);
+    layer.count = readDisplayIndex(&CLOCK_LAYER_RANGES[i][1]);
+    layer.buffer = new uint8_t[layer.count];
+    memset(layer.buffer, 0, layer.count);
+    layer.brightness = 255;
+    layer.blendMode = BLEND_MODE_REPLACE;
+    layer.enabled = (i == CLOCK_LAYER_BASE || i == CLOCK_LAYER_FACE);
+    invalidateLayer(layer);
+  }
+
+  lastDirtyStart = CLOCK_DISPLAY_LED_COUNT;
+  lastDirtyEnd = 0;
+}
+
+ClockCompositor::~ClockCompositor() {
+  for (uint8_t i = 0; i < CLOCK_LAYER_COUNT; ++i) {
+    delete[] layers[i].buffer;
+  }
+}
+
+FrameBufferView *ClockCompositor::newLayerView(uint8_t layer, ClockDisplayIndex startIndex, uint8_t count) {
+  Layer &target = layers[min(layer, CLOCK_LAYER_COUNT - 1)];
+  ClockDisplayIndex realStartIndex = constrain(startIndex, target.offset, target.offset + target.count - 1) - target.offset;
+  uint8_t realCount = min(count, target.count - realStartIndex);
+  return new FrameBufferView(target.buffer + realStartIndex, realCount, &target.dirty, target.offset + realStartIndex);
+}
+
+void ClockCompositor::setLayerEnabled(uint8_t layer, bool enabled) {
+  if (layer < CLOCK_LAYER_COUNT && layers[layer].enabled != enabled) {
+    layers[layer].enabled = enabled;
+    invalidateLayer(layers[layer]);
+  }
+}
+
+void ClockCompositor::setLayerBrightness(uint8_t layer, uint8_t brightness) {
+  if (layer < CLOCK_LAYER_COUNT && layers[layer].brightness != brightness) {
+    layers[layer].brightness = brightness;
+    invalidateLayer(layers[layer]);
+  }
+}
+
+void ClockCompositor::setLayerBlendMode(uint8_t layer, uint8_t blendMode) {
+  if (layer < CLOCK_LAYER_COUNT && layers[layer].blendMode != blendMode) {
+    layers[layer].blendMode = blendMode;
+    invalidateLayer(layers[layer]);
+  }
+}
+
+void ClockCompositor::invalidate() {
+  for (uint8_t i = 0; i < CLOCK_LAYER_COUNT; ++i) {
+    invalidateLayer(layers[i]);
+  }
+}
+
+void ClockCompositor::invalidateLayer(Layer &layer) {
+  layer.dirty.merge(layer.offset, layer.offset + layer.count);
+}
+
+void ClockCompositor::composite() {
+  // The back buffer is still waiting to be shown
+  if (clockDisplay.isSwapPending()) {
+    return;
+  }
+
+  // Merge the display ranges modified in each layer
+  ClockDisplayIndex dirtyStart = CLOCK_DISPLAY_LED_COUNT;
+  ClockDisplayIndex dirtyEnd = 0;
+  for (uint8_t i = 0; i < CLOCK_LAYER_COUNT; ++i) {
+    Layer &layer = layers[i];
+    if (!layer.dirty.isEmpty()) {
+      dirtyStart = min(dirtyStart, layer.dirty.start);
+      dirtyEnd = max(dirtyEnd, layer.dirty.end);
+      layer.dirty.clear();
+    }
+  }
+
+  // The back buffer missed whatever was rebuilt for the previous frame
+  ClockDisplayIndex rebuildStart = min(dirtyStart, lastDirtyStart);
+  ClockDisplayIndex rebuildEnd = max(dirtyEnd, lastDirtyEnd);
+  lastDirtyStart = dirtyStart;
+  lastDirtyEnd = dirtyEnd;
+  if (rebuildStart >= rebuildEnd) {
+    return;
+  }
+
+  // Rebuild that range from every layer which overlaps it, bottom to top
+  BasicFrameBufferView<ClockDisplayIndex> output(clockDisplay.getBackBuffer(), CLOCK_DISPLAY_LED_COUNT);
+  output.setValues(rebuildStart, rebuildEnd - rebuildStart, 0);
+  for (uint8_t i = 0; i < CLOCK_LAYER_COUNT; ++i) {
+    Layer &layer = layers[i];
+    if (layer.enabled) {
+      ClockDisplayIndex start = max(rebuildStart, layer.offset);
+      ClockDisplayIndex end = min(rebuildEnd, layer.offset + layer.count);
+      if (start < end) {
+        output.blendValues(layer.buffer + (start - layer.offset), start, end - start, layer.brightness, layer.blendMode);
+      }
+    }
+  }
+  clockDisplay.applyTrim(rebuildStart, rebuildEnd - rebuildStart);
+  clockDisplay.requestSwap();
+}
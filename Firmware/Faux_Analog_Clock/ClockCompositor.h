@@ -0,0 +1,94 @@
+#ifndef CLOCK_COMPOSITOR_H
+#define CLOCK_COMPOSITOR_H
+
+#include "FrameBufferView.h"
+#include "ClockDisplay.h"
+
+/**
+ * Compositing layers, from bottom to top
+ */
+const uint8_t CLOCK_LAYER_BASE = 0;    // Display mode (hands and pendulum) and AM/PM indicator
+const uint8_t CLOCK_LAYER_FACE = 1;    // Clock face ring effects
+const uint8_t CLOCK_LAYER_OVERLAY = 2; // Clock face ring overlay (time set animation)
+const uint8_t CLOCK_LAYER_MENU = 3;    // Menu text
+const uint8_t CLOCK_LAYER_COUNT = 4;
+
+/**
+ * Composites ordered layers into the clock display frame buffer.
+ * Each layer has its own buffer covering a range of the display, along with its own brightness and blend mode.
+ * Each layer records the range of display indices its views modified, and only the union of those ranges is rebuilt
+ * (so a pendulum step rebuilds a couple of LEDs rather than the whole base layer).
+ * Composites are drawn into the clock display's back buffer; since the back buffer holds the frame before last,
+ * the range rebuilt for the previous frame is rebuilt again as well.
+ */
+class ClockCompositor {
+public:
+  /**
+   * Creates the layers for the given clock display
+   */
+  ClockCompositor(ClockDisplay &clockDisplay);
+
+  /**
+   * Deletes all layer buffers
+   */
+  ~ClockCompositor();
+
+  /**
+   * Creates a view of a layer's buffer
+   * NOTE: The caller is responsible for deleting this view!
+   * 
+   * @param layer The layer to view (see CLOCK_LAYER_*)
+   * @param startIndex The first index of the view, as a clock display LED index (must be within the layer)
+   * @param count The number of values to view
+   */
+  FrameBufferView *newLayerView(uint8_t layer, ClockDisplayIndex startIndex, uint8_t count);
+
+  /**
+   * Sets whether the given layer is shown
+   */
+  void setLayerEnabled(uint8_t layer, bool enabled);
+
+  /**
+   * Sets the brightness by which the given layer's values are multiplied
+   */
+  void setLayerBrightness(uint8_t layer, uint8_t brightness);
+
+  /**
+   * Sets how the given layer is combined with the layers below it (see BLEND_MODE_*)
+   */
+  void setLayerBlendMode(uint8_t layer, uint8_t blendMode);
+
+  /**
+   * Forces all layers to be composited again (e.g. after writing to the clock display directly)
+   */
+  void invalidate();
+
+  /**
+   * Composites all changed layers into the clock display back buffer and requests a swap
+   * (does nothing while the previous swap is still pending)
+   */
+  void composite();
+
+private:
+  struct Layer {
+    uint8_t *buffer;
+    ClockDisplayIndex offset;
+    ClockDisplayIndex count;
+    uint8_t brightness;
+    uint8_t blendMode;
+    bool enabled;
+    FrameBufferDirtyRange<ClockDisplayIndex> dirty; // In display indices
+  };
+
+  ClockDisplay &clockDisplay;
+  Layer layers[CLOCK_LAYER_COUNT];
+  ClockDisplayIndex lastDirtyStart;
+  ClockDisplayIndex lastDirtyEnd;
+
+  /**
+   * Marks the whole range of the given layer as modified
+   */
+  void invalidateLayer(Layer &layer);
+};
+
+#endif
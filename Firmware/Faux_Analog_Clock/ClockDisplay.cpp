@@ -1,147 +1,369 @@
 #include "Arduino.h"
+#include <avr/sleep.h>
+#include "EEPROM.h"
+#include "ClockTime.h"
+#include "Trace.h"
 #include "FrameBufferView.h"
+#include "Kernels.h"
+#include "ConstexprTable.h"
 #include "ClockDisplay.h"
 
-#define NOP __asm__ __volatile__ ("nop\n\t")
-
-const uint8_t CLOCK_DISPLAY_PORTB_MASK = 0b00001111;
-const uint8_t CLOCK_DISPLAY_PORTC_MASK = 0b00000011;
-
-const uint8_t PIN_MASKS[CLOCK_DISPLAY_PIN_COUNT] = {
-  0b00000001,
-  0b00000010,
-  0b00000100,
-  0b00001000,
-  0b00010000,
-  0b00100000,
-  0b01000000,
-  0b10000000,
-  0b00000001,
-  0b00000010,
-  0b00000100,
-  0b00001000,
-  0b00000001,
-  0b00000010
+#define CLOCK_DISPLAY_INLINE inline __attribute__((always_inline))
+
+/**
+ * Gets the data direction register of the given port (see CLOCK_BOARD_PORT_*)
+ */
+static CLOCK_DISPLAY_INLINE volatile uint8_t &boardDDR(uint8_t port) {
+  return port == CLOCK_BOARD_PORT_B ? DDRB : (port == CLOCK_BOARD_PORT_C ? DDRC : DDRD);
+}
+
+/**
+ * Gets the output register of the given port (see CLOCK_BOARD_PORT_*)
+ */
+static CLOCK_DISPLAY_INLINE volatile uint8_t &boardPORT(uint8_t port) {
+  return port == CLOCK_BOARD_PORT_B ? PORTB : (port == CLOCK_BOARD_PORT_C ? PORTC : PORTD);
+}
+
+/**
+ * Drives and releases a line of a Charlieplex board (the port and bit are constants, so each access is a single
+ * sbi/cbi instruction)
+ */
+template<uint8_t LineCount, uint8_t Line>
+struct CharlieplexLineAccess {
+  static const uint8_t LINE_PORT = CharlieplexBoard<LineCount>::line(Line).port;
+  static const uint8_t LINE_MASK = _BV(CharlieplexBoard<LineCount>::line(Line).bit);
+
+  static CLOCK_DISPLAY_INLINE void drivePositive() {
+    boardDDR(LINE_PORT) |= LINE_MASK;
+    boardPORT(LINE_PORT) |= LINE_MASK;
+  }
+
+  static CLOCK_DISPLAY_INLINE void releasePositive() {
+    boardPORT(LINE_PORT) &= static_cast<uint8_t>(~LINE_MASK);
+    boardDDR(LINE_PORT) &= static_cast<uint8_t>(~LINE_MASK);
+  }
+};
+
+/**
+ * The data direction masks of a Charlieplex line (zero for the ports it isn't on), so that a line chosen at run time is
+ * driven and released in constant time, without branching on its port
+ */
+struct CharlieplexLineMasks {
+  uint8_t portB;
+  uint8_t portC;
+  uint8_t portD;
+};
+
+/**
+ * Generates the masks of every line of a Charlieplex board (see ConstexprTable.h)
+ */
+template<uint8_t LineCount>
+struct CharlieplexLineMaskGenerator {
+  typedef CharlieplexLineMasks Type;
+  static const uint16_t SIZE = LineCount;
+
+  static constexpr uint8_t mask(uint16_t line, uint8_t port) {
+    return CharlieplexBoard<LineCount>::line(line).port == port ? _BV(CharlieplexBoard<LineCount>::line(line).bit) : 0;
+  }
+
+  static constexpr Type value(uint16_t line) {
+    return CharlieplexLineMasks { mask(line, CLOCK_BOARD_PORT_B), mask(line, CLOCK_BOARD_PORT_C), mask(line, CLOCK_BOARD_PORT_D) };
+  }
 };
 
-ClockDisplay::ClockDisplay() {
-  for (uint8_t i = 0; i < CLOCK_DISPLAY_LED_COUNT; ++i) {
-    frameBuffer[i] = 0;
+/**
+ * Generates the frame buffer index of each LED lit while the given line is positive, in scan order (one table per line;
+ * see ConstexprTable.h)
+ */
+template<uint8_t LineCount, uint8_t PositiveLine, typename Index>
+struct CharlieplexLineLEDGenerator {
+  typedef Index Type;
+  static const uint16_t SIZE = LineCount - 1;
+
+  static constexpr Type value(uint16_t negativeSlot) {
+    return static_cast<Index>(CharlieplexBoard<LineCount>::logicalLED(static_cast<uint16_t>(PositiveLine) * (LineCount - 1) + negativeSlot));
   }
+};
+
+/**
+ * Reads a frame buffer index from a PROGMEM table
+ */
+static CLOCK_DISPLAY_INLINE uint8_t readIndex_P(const uint8_t *address) {
+  return pgm_read_byte(address);
 }
 
-void ClockDisplay::begin() {
-  DDRD = 0;
-  PORTD = 0;
-  DDRB &= ~CLOCK_DISPLAY_PORTB_MASK;
-  PORTB &= ~CLOCK_DISPLAY_PORTB_MASK;
-  DDRC &= ~CLOCK_DISPLAY_PORTC_MASK;
-  PORTC &= ~CLOCK_DISPLAY_PORTC_MASK;
+static CLOCK_DISPLAY_INLINE uint16_t readIndex_P(const uint16_t *address) {
+  return pgm_read_word(address);
 }
 
+/**
+ * The state carried through a scan (OffTime must hold 255 times the LED count)
+ */
+template<typename OffTime>
+struct CharlieplexScanState {
+  const uint8_t *frameBuffer;
+  OffTime offTime;
+  bool anyLEDLit;
+};
 
-void ClockDisplay::display() {
-  uint8_t ledIndex = 0;
-  for (uint8_t pos = 0; pos < CLOCK_DISPLAY_PIN_COUNT; ++pos) {
-    // Set positive Charlieplex line
-    uint8_t posMask = PIN_MASKS[pos];
-    if (pos < 8) {
-      DDRD = posMask;
-      PORTD = posMask;
-    } else if (pos < 12) {
-      DDRB |= posMask;
-      PORTB |= posMask;
-    } else {
-      DDRC |= posMask;
-      PORTC |= posMask;
-    }
+/**
+ * Scans the LEDs of a Charlieplex board from the given positive line to the last.
+ * The positive lines are unrolled at compile time (so each is driven with a single sbi/cbi pair); the LEDs of a line are
+ * scanned by a loop over that line's tables, which keeps the flash used by the scan close to that of a plain loop.
+ */
+template<uint8_t LineCount, typename Index, uint8_t PositiveLine = 0, bool Done = (PositiveLine >= LineCount)>
+struct CharlieplexScan {
+  typedef ConstexprTable<CharlieplexLineMaskGenerator<LineCount> > LineMasks;
+  typedef ConstexprTable<CharlieplexLineLEDGenerator<LineCount, PositiveLine, Index> > LineLEDs;
+
+  template<typename OffTime>
+  static CLOCK_DISPLAY_INLINE void scan(CharlieplexScanState<OffTime> &state) {
+    CharlieplexLineAccess<LineCount, PositiveLine>::drivePositive();
+
+    for (uint8_t negativeSlot = 0; negativeSlot < LineCount - 1; ++negativeSlot) {
+      // No need to toggle any lines if the LED is off (this does change the timing a bit, but it's fine)
+      uint8_t ledValue = state.frameBuffer[readIndex_P(LineLEDs::values + negativeSlot)];
+      if (ledValue > 0) {
+        state.anyLEDLit = true;
+
+        // Set negative Charlieplex line (its output is already low), wait for the on time, then clear it
+        CharlieplexLineMasks masks;
+        memcpy_P(&masks, LineMasks::values + (negativeSlot < PositiveLine ? negativeSlot : negativeSlot + 1), sizeof(masks));
+        DDRB |= masks.portB;
+        DDRC |= masks.portC;
+        DDRD |= masks.portD;
+        waitIterations(ledValue);
+        DDRB &= static_cast<uint8_t>(~masks.portB);
+        DDRC &= static_cast<uint8_t>(~masks.portC);
+        DDRD &= static_cast<uint8_t>(~masks.portD);
 
-    for (uint8_t neg = 0; neg < CLOCK_DISPLAY_PIN_COUNT; ++neg) {
-      // There's obviously no LED that has both leads connected to the same line, so skip this case
-      if (pos != neg) {
-        uint8_t ledValue = frameBuffer[ledIndex];
-
-        // No need to toggle any lines if the LED is off (this does change the timing a bit, but it's fine)
-        if (ledValue > 0) {
-          // Set negative Charlieplex line (output should already be low)
-          uint8_t negMask = PIN_MASKS[neg];
-          if (neg < 8) {
-            DDRD |= negMask;
-          } else if (neg < 12) {
-            DDRB |= negMask;
-          } else {
-            DDRC |= negMask;
-          }
-        
-          // On Delay
-          timedWait(ledValue);
-
-          // Clear negative Charlieplex line
-          negMask = ~negMask;
-          if (neg < 8) {
-            DDRD &= negMask;
-          } else if (neg < 12) {
-            DDRB &= negMask;
-          } else {
-            DDRC &= negMask;
-          }
-
-          // Off delay
-          if (ledValue < 255) {
-            timedWait(255 - ledValue);
-          }
-        }
-
-        // Move to the next LED
-        ++ledIndex;
+        // Off delay (slept through at the end of the frame)
+        state.offTime += 255 - ledValue;
       }
     }
 
-    // Clear positive Charlieplex line
-    posMask = ~posMask;
-    if (pos < 8) {
-      PORTD &= posMask;
-      DDRD &= posMask;
-    } else if (pos < 12) {
-      PORTB &= posMask;
-      DDRB &= posMask;
-    } else {
-      PORTC &= posMask;
-      DDRC &= posMask;
+    CharlieplexLineAccess<LineCount, PositiveLine>::releasePositive();
+
+    CharlieplexScan<LineCount, Index, PositiveLine + 1>::scan(state);
+  }
+};
+
+template<uint8_t LineCount, typename Index, uint8_t PositiveLine>
+struct CharlieplexScan<LineCount, Index, PositiveLine, true> {
+  template<typename OffTime>
+  static CLOCK_DISPLAY_INLINE void scan(CharlieplexScanState<OffTime> & /* state */) {
+  }
+};
+
+// Set by the timer 2 compare interrupt when an idle sleep is over
+static volatile bool idleSleepFinished = false;
+
+ISR(TIMER2_COMPA_vect) {
+  idleSleepFinished = true;
+}
+
+CharlieplexDisplayBase::CharlieplexDisplayBase() {
+  idleWindowStartMicros = 0;
+  idleMicros = 0;
+  idlePercent = 0;
+}
+
+uint8_t CharlieplexDisplayBase::getIdlePercent() const {
+  return idlePercent;
+}
+
+void CharlieplexDisplayBase::beginIdleSleep() {
+  // Timer 2 in CTC mode, stopped until needed
+  TCCR2A = _BV(WGM21);
+  TCCR2B = 0;
+  TIMSK2 = 0;
+  idleWindowStartMicros = clockMicros();
+}
+
+void CharlieplexDisplayBase::idleSleep(uint16_t ticks) {
+  uint32_t startMicros = clockMicros();
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while (ticks > 0) {
+    uint8_t chunk = static_cast<uint8_t>(min(ticks, 255));
+    ticks -= chunk;
+
+    // Start timer 2 at clk/32 (2 us per tick)
+    idleSleepFinished = false;
+    TCNT2 = 0;
+    OCR2A = chunk - 1;
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 = _BV(OCIE2A);
+    TCCR2B = _BV(CS21) | _BV(CS20);
+
+    // Sleep until the compare match (other interrupts, such as the millis() timer or the GPS serial port, wake the CPU early)
+    // Interrupts are only re-enabled right before sleeping, so the compare match can't slip in between the check and the sleep
+    cli();
+    while (!idleSleepFinished) {
+      sleep_enable();
+      sei();
+      sleep_cpu();
+      sleep_disable();
+      cli();
     }
+    sei();
+  }
+  TCCR2B = 0;
+  TIMSK2 = 0;
+
+  // Update the idle percentage once per measurement window
+  uint32_t currentMicros = clockMicros();
+  idleMicros += currentMicros - startMicros;
+  uint32_t windowMicros = currentMicros - idleWindowStartMicros;
+  if (windowMicros >= CLOCK_DISPLAY_IDLE_WINDOW_MICROS) {
+    idlePercent = static_cast<uint8_t>(min(idleMicros * 100 / windowMicros, 100UL));
+    idleMicros = 0;
+    idleWindowStartMicros = currentMicros;
+  }
+}
+
+template<uint8_t LineCount, typename Index>
+const Index CharlieplexDisplay<LineCount, Index>::LED_COUNT;
+
+template<uint8_t LineCount, typename Index>
+CharlieplexDisplay<LineCount, Index>::CharlieplexDisplay() {
+  memset(frameBuffers, 0, sizeof(frameBuffers));
+  frontBuffer = frameBuffers[0];
+  backBuffer = frameBuffers[1];
+  swapRequested = false;
+  memset(trimSteps, 0, sizeof(trimSteps));
+}
+
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::begin() {
+  DDRB &= static_cast<uint8_t>(~charlieplexPortMask<LineCount>(CLOCK_BOARD_PORT_B));
+  PORTB &= static_cast<uint8_t>(~charlieplexPortMask<LineCount>(CLOCK_BOARD_PORT_B));
+  DDRC &= static_cast<uint8_t>(~charlieplexPortMask<LineCount>(CLOCK_BOARD_PORT_C));
+  PORTC &= static_cast<uint8_t>(~charlieplexPortMask<LineCount>(CLOCK_BOARD_PORT_C));
+  DDRD &= static_cast<uint8_t>(~charlieplexPortMask<LineCount>(CLOCK_BOARD_PORT_D));
+  PORTD &= static_cast<uint8_t>(~charlieplexPortMask<LineCount>(CLOCK_BOARD_PORT_D));
+
+  // Load the trims (an erased EEPROM reads 255, which leaves the LED at full brightness)
+  for (Index i = 0; i < LED_COUNT; ++i) {
+    uint8_t steps = (255 - EEPROM.read(CLOCK_DISPLAY_TRIM_EEPROM_ADDRESS + i)) / CLOCK_DISPLAY_TRIM_STEP;
+    trimSteps[i >> 1] |= (i & 1) != 0 ? steps << 4 : steps;
+  }
+
+  beginIdleSleep();
+}
+
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::display() {
+  // Frame boundary: show the back buffer if requested
+  if (swapRequested) {
+    uint8_t *buffer = frontBuffer;
+    frontBuffer = backBuffer;
+    backBuffer = buffer;
+    swapRequested = false;
+    TRACE(TRACE_EVENT_FRAME_SWAP, 0);
+  }
+
+  const uint8_t *frameBuffer = frontBuffer;
+
+#ifdef CLOCK_VIRTUAL_TIME
+  // There are no LEDs to drive; just take as long as a real frame (each lit LED takes 255 waitIterations() iterations),
+  // or CLOCK_VIRTUAL_MIN_FRAME_MICROS if that's longer (so a harness can trade frame rate for simulation speed)
+  uint32_t litCount = 0;
+  for (Index i = 0; i < LED_COUNT; ++i) {
+    litCount += frameBuffer[i] > 0 ? 1 : 0;
   }
+  uint32_t frameMicros = litCount > 0 ? (litCount * 255 * WAIT_CYCLES_PER_4_ITERATIONS) >> 6 : static_cast<uint32_t>(CLOCK_DISPLAY_DARK_FRAME_TICKS) * 2;
+  advanceClockTime(max(frameMicros, CLOCK_VIRTUAL_MIN_FRAME_MICROS));
+  return;
+#endif
+
+  CharlieplexScanState<typename FrameBufferIndexTraits<Index>::WideIndex> state;
+  state.frameBuffer = frameBuffer;
+  state.offTime = 0;
+  state.anyLEDLit = false;
+  CharlieplexScan<LineCount, Index>::scan(state);
+
+  // Sleep through the off time (four waitIterations() iterations take WAIT_CYCLES_PER_4_ITERATIONS cycles, one timer 2 tick is 32 cycles)
+  idleSleep(state.anyLEDLit ? static_cast<uint16_t>((static_cast<uint32_t>(state.offTime) * WAIT_CYCLES_PER_4_ITERATIONS) >> 7) : CLOCK_DISPLAY_DARK_FRAME_TICKS);
+}
+
+template<uint8_t LineCount, typename Index>
+uint8_t *CharlieplexDisplay<LineCount, Index>::getBackBuffer() {
+  return backBuffer;
 }
 
-void ClockDisplay::setLEDValue(uint8_t index, uint8_t value) {
-  if (index < CLOCK_DISPLAY_LED_COUNT) {
-    frameBuffer[index] = value;
+template<uint8_t LineCount, typename Index>
+const uint8_t *CharlieplexDisplay<LineCount, Index>::getFrontBuffer() const {
+  return frontBuffer;
+}
+
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::requestSwap() {
+  swapRequested = true;
+}
+
+template<uint8_t LineCount, typename Index>
+bool CharlieplexDisplay<LineCount, Index>::isSwapPending() const {
+  return swapRequested;
+}
+
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::setLEDValue(Index index, uint8_t value) {
+  if (index < LED_COUNT) {
+    frameBuffers[0][index] = value;
+    frameBuffers[1][index] = value;
   }
 }
 
-void ClockDisplay::setLEDValues(uint8_t *source, uint8_t destIndex, uint8_t count) {
-  uint8_t realCount = destIndex >= CLOCK_DISPLAY_LED_COUNT ? 0 : min(CLOCK_DISPLAY_LED_COUNT - destIndex, count);
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::setLEDValues(uint8_t *source, Index destIndex, Index count) {
+  Index realCount = destIndex >= LED_COUNT ? 0 : min(static_cast<Index>(LED_COUNT - destIndex), count);
   if (realCount > 0) {
-    memcpy(frameBuffer + destIndex, source, realCount);
+    memcpy(frameBuffers[0] + destIndex, source, realCount);
+    memcpy(frameBuffers[1] + destIndex, source, realCount);
   }
 }
 
-void ClockDisplay::setAllLEDValues(uint8_t value) {
-  memset(frameBuffer, value, CLOCK_DISPLAY_LED_COUNT);
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::setAllLEDValues(uint8_t value) {
+  memset(frameBuffers, value, sizeof(frameBuffers));
 }
 
-FrameBufferView *ClockDisplay::newFrameBufferView(uint8_t startIndex, uint8_t count) {
-  uint8_t realStartIndex = min(startIndex, CLOCK_DISPLAY_LED_COUNT - 1);
-  uint8_t realCount = min(count, CLOCK_DISPLAY_LED_COUNT - realStartIndex);
-  return new FrameBufferView(frameBuffer + realStartIndex, realCount);
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::applyTrim(Index startIndex, Index count) {
+  Index endIndex = static_cast<Index>(min(static_cast<uint32_t>(startIndex) + count, static_cast<uint32_t>(LED_COUNT)));
+  for (Index i = startIndex; i < endIndex; ++i) {
+    // Untrimmed LEDs (most of them) are left as they are
+    if (getTrimSteps(i) != 0) {
+      backBuffer[i] = getTrimmedValue(i, backBuffer[i]);
+    }
+  }
 }
 
+template<uint8_t LineCount, typename Index>
+uint8_t CharlieplexDisplay<LineCount, Index>::getLEDTrim(Index index) const {
+  return index < LED_COUNT ? 255 - getTrimSteps(index) * CLOCK_DISPLAY_TRIM_STEP : 255;
+}
 
-void ClockDisplay::timedWait(uint8_t timeFrame) {
-  // 15 ms scan at a delay length of 1 NOP
-  // 18 ms scan at a delay length of 2 NOPs
-  // 21 ms scan at a delay length of 3 NOPs
-  // Basically 15 ms + 3 ms * (NOPs - 1)
-  for (uint8_t i = 0; i < timeFrame; ++i) {
-    NOP; NOP; NOP;
+template<uint8_t LineCount, typename Index>
+void CharlieplexDisplay<LineCount, Index>::setLEDTrim(Index index, uint8_t trim) {
+  if (index < LED_COUNT) {
+    uint8_t steps = (255 - trim) / CLOCK_DISPLAY_TRIM_STEP;
+    uint8_t shift = (index & 1) != 0 ? 4 : 0;
+    trimSteps[index >> 1] = (trimSteps[index >> 1] & ~(0x0F << shift)) | (steps << shift);
+    EEPROM.update(CLOCK_DISPLAY_TRIM_EEPROM_ADDRESS + index, getLEDTrim(index));
   }
 }
+
+template<uint8_t LineCount, typename Index>
+uint8_t CharlieplexDisplay<LineCount, Index>::getTrimmedValue(Index index, uint8_t value) const {
+  return static_cast<uint8_t>((static_cast<uint16_t>(value) * (getLEDTrim(index) + 1)) >> 8);
+}
+
+template<uint8_t LineCount, typename Index>
+uint8_t CharlieplexDisplay<LineCount, Index>::getTrimSteps(Index index) const {
+  uint8_t steps = trimSteps[index >> 1];
+  return (index & 1) != 0 ? steps >> 4 : steps & 0x0F;
+}
+
+// The clock display (see ClockDisplay.h)
+template class CharlieplexDisplay<CLOCK_DISPLAY_PIN_COUNT, ClockDisplayIndex>;
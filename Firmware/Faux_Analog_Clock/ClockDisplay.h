@@ -2,48 +2,159 @@
 #define CLOCK_DISPLAY_H
 
 #include "FrameBufferView.h"
+#include "ClockBoard.h"
 
-const uint8_t CLOCK_DISPLAY_LED_COUNT = 182;
+/**
+ * The type of the clock display's LED indices (uint8_t covers up to 16 lines and 240 LEDs, uint16_t is needed beyond that)
+ */
+typedef uint8_t ClockDisplayIndex;
+
+const ClockDisplayIndex CLOCK_DISPLAY_LED_COUNT = 182;
 const uint8_t CLOCK_DISPLAY_PIN_COUNT = 14;
 
-const uint8_t CLOCK_SECONDS_OFFSET = 0;
-const uint8_t CLOCK_MINUTES_OFFSET = 60;
-const uint8_t CLOCK_HOURS_OFFSET = 120;
-const uint8_t CLOCK_PENDULUM_OFFSET = 132;
-const uint8_t CLOCK_FACE_INNER_OFFSET = 144;
-const uint8_t CLOCK_FACE_OUTER_OFFSET = 156;
-const uint8_t CLOCK_7SEG_LEFT_OFFSET = 168;
-const uint8_t CLOCK_7SEG_RIGHT_OFFSET = 175;
+static_assert(CLOCK_DISPLAY_PIN_COUNT == CLOCK_BOARD_LINE_COUNT && CLOCK_DISPLAY_LED_COUNT == CLOCK_BOARD_LED_COUNT,
+  "The clock display must match the board description (see ClockBoard.h)");
+
+const ClockDisplayIndex CLOCK_SECONDS_OFFSET = 0;
+const ClockDisplayIndex CLOCK_MINUTES_OFFSET = 60;
+const ClockDisplayIndex CLOCK_HOURS_OFFSET = 120;
+const ClockDisplayIndex CLOCK_PENDULUM_OFFSET = 132;
+const ClockDisplayIndex CLOCK_FACE_INNER_OFFSET = 144;
+const ClockDisplayIndex CLOCK_FACE_OUTER_OFFSET = 156;
+const ClockDisplayIndex CLOCK_7SEG_LEFT_OFFSET = 168;
+const ClockDisplayIndex CLOCK_7SEG_RIGHT_OFFSET = 175;
+
+/**
+ * The length of the idle sleep which replaces a fully dark frame, in timer 2 ticks (2 us each)
+ */
+const uint16_t CLOCK_DISPLAY_DARK_FRAME_TICKS = 5000;
+
+/**
+ * The interval over which the CPU idle percentage is measured, in microseconds
+ */
+const uint32_t CLOCK_DISPLAY_IDLE_WINDOW_MICROS = 1000000;
+
+/**
+ * The EEPROM address of the per-LED trim table (CLOCK_DISPLAY_LED_COUNT bytes, after the clock options)
+ */
+const uint16_t CLOCK_DISPLAY_TRIM_EEPROM_ADDRESS = 64;
+
+/**
+ * The amount by which each calibration step dims an LED (trims are kept in RAM as a number of steps, 4 bits per LED)
+ */
+const uint8_t CLOCK_DISPLAY_TRIM_STEP = 16;
+
+static_assert(CLOCK_DISPLAY_TRIM_STEP >= 16, "Trim levels must fit in 4 bits");
 
 /**
- * Charlieplexed clock display using 14 I/O lines to control 182 LEDs.
- * The I/O pins used for this are hard-coded:
+ * The parts of a Charlieplexed display which don't depend on its size: the idle sleep which replaces LED off time
+ * (timed by timer 2), and the idle percentage
+ */
+class CharlieplexDisplayBase {
+public:
+  CharlieplexDisplayBase();
+
+  /**
+   * Gets the percentage of time the CPU spent in idle sleep during the last CLOCK_DISPLAY_IDLE_WINDOW_MICROS
+   */
+  uint8_t getIdlePercent() const;
+
+protected:
+  /**
+   * Sets up the idle sleep timer (timer 2)
+   */
+  void beginIdleSleep();
+
+  /**
+   * Puts the CPU into idle sleep for the given number of timer 2 ticks, then updates the idle percentage
+   */
+  void idleSleep(uint16_t ticks);
+
+private:
+  uint32_t idleWindowStartMicros;
+  uint32_t idleMicros;
+  uint8_t idlePercent;
+};
+
+/**
+ * Charlieplexed display using LineCount I/O lines to control LineCount * (LineCount - 1) LEDs, indexed by Index.
+ * The I/O pins used for this, and the order of the LEDs, are described by CharlieplexBoard<LineCount> (see ClockBoard.h).
+ * The clock uses 14 lines to control 182 LEDs (ClockDisplay):
  * 
  * PORTD 0..7
  * PORTB 0..3
  * PORTC 0..1
+ * 
+ * The scan is generated from the board description at compile time: the positive lines are unrolled, and each line's
+ * LEDs are scanned by a loop over constant tables. Its code size grows with the line count, its tables with the LED count,
+ * and so does the frame time (every LED has a 255 step on/off slot).
+ * 
+ * The display is double buffered: frames are drawn into the back buffer while the front buffer is scanned,
+ * and the two are swapped (by pointer) only at a frame boundary, so a scan never shows a half-drawn frame.
+ * 
+ * Each lit LED is followed by an off time which keeps its duty cycle proportional to its value.
+ * Rather than spinning, the display adds up the off time of a frame and puts the CPU into idle sleep for it at the
+ * end of the frame (timer 2 wakes it up), so the CPU only runs while there is work to do.
+ * 
+ * Each LED has a trim value (stored in EEPROM, 255 = full brightness) which evens out LEDs from different batches.
+ * Trims are applied to the back buffer as frames are drawn (see applyTrim()), so scanning doesn't pay for them.
+ * They are read from EEPROM once, in begin(), and kept in RAM as a number of CLOCK_DISPLAY_TRIM_STEP steps below full
+ * brightness (two LEDs per byte), so trims between steps are rounded up to the next step.
  */
-class ClockDisplay {
+template<uint8_t LineCount, typename Index>
+class CharlieplexDisplay : public CharlieplexDisplayBase {
 public:
   /**
-   * Basic clock display constructor
+   * The number of LEDs
    */
-  ClockDisplay();
+  static const Index LED_COUNT = static_cast<Index>(static_cast<uint16_t>(LineCount) * (LineCount - 1));
+
+  static_assert(static_cast<uint32_t>(LineCount) * (LineCount - 1) <= static_cast<Index>(-1), "Index is too small for this many LEDs");
 
   /**
-   * Begins the clock display, setting up I/O pins
+   * Basic Charlieplexed display constructor
+   */
+  CharlieplexDisplay();
+
+  /**
+   * Begins the clock display, setting up I/O pins and the idle sleep timer (timer 2), and loads the LED trims
    */
   void begin();
 
   /**
-   * Displays the clock LEDs for one frame's duration
+   * Displays the clock LEDs for one frame's duration, swapping the front and back buffers first if a swap was requested
    */
   void display();
 
+  /**
+   * Gets the back buffer (LED_COUNT values), into which the next frame is drawn.
+   * Do not hold on to this pointer; it changes with every swap.
+   */
+  uint8_t *getBackBuffer();
+
+  /**
+   * Gets the front buffer (LED_COUNT values), which is being shown (for debugging and host tests; it must not be modified)
+   */
+  const uint8_t *getFrontBuffer() const;
+
+  /**
+   * Requests that the back buffer be shown, starting with the next frame
+   */
+  void requestSwap();
+
+  /**
+   * Returns true if a requested swap has not happened yet (the back buffer must not be modified until it has)
+   */
+  bool isSwapPending() const;
+
+  /*
+   * The following setters write both buffers immediately (they are meant for test patterns, not tear-free drawing)
+   */
+
   /**
    * Sets the LED value at the given index.
    */
-  void setLEDValue(uint8_t index, uint8_t value);
+  void setLEDValue(Index index, uint8_t value);
 
   /**
    * Sets multiple LED values by copying them from an array of values
@@ -52,7 +163,7 @@ public:
    * @param destIndex The index to copy into
    * @param count The number of values to copy
    */
-  void setLEDValues(uint8_t *source, uint8_t destIndex, uint8_t count);
+  void setLEDValues(uint8_t *source, Index destIndex, Index count);
 
   /**
    * Sets all LEDs to the same value
@@ -60,21 +171,46 @@ public:
   void setAllLEDValues(uint8_t value);
 
   /**
-   * Creates a view of the internal frame buffer
-   * NOTE: The caller is responsible for deleting this view!
+   * Scales a range of the back buffer by the per-LED trim values; call this after drawing into that range
    * 
-   * @param startIndex The first index of the view
-   * @param count The number of bytes to view
+   * @param startIndex The first LED to trim
+   * @param count The number of LEDs to trim
    */
-  FrameBufferView *newFrameBufferView(uint8_t startIndex, uint8_t count);
+  void applyTrim(Index startIndex, Index count);
+
+  /**
+   * Gets the trim value (0..255, where 255 leaves the LED at full brightness) of the given LED
+   */
+  uint8_t getLEDTrim(Index index) const;
+
+  /**
+   * Sets (and saves) the trim value of the given LED (rounded up to a whole number of CLOCK_DISPLAY_TRIM_STEP steps)
+   */
+  void setLEDTrim(Index index, uint8_t trim);
+
+  /**
+   * Applies the given LED's trim to the given value
+   */
+  uint8_t getTrimmedValue(Index index, uint8_t value) const;
 
 private:
-  uint8_t frameBuffer[CLOCK_DISPLAY_LED_COUNT];
+  uint8_t frameBuffers[2][LED_COUNT];
+  uint8_t *frontBuffer;
+  uint8_t *backBuffer;
+  volatile bool swapRequested;
+
+  // The number of trim steps below full brightness of each LED (the low nibble holds the even LED)
+  uint8_t trimSteps[(LED_COUNT + 1) / 2];
 
   /**
-   * Waits for the specified time frame
+   * Gets the number of trim steps below full brightness of the given LED
    */
-  void timedWait(uint8_t timeFrame);
+  uint8_t getTrimSteps(Index index) const;
 };
 
+/**
+ * The clock display (its members are instantiated in ClockDisplay.cpp)
+ */
+typedef CharlieplexDisplay<CLOCK_DISPLAY_PIN_COUNT, ClockDisplayIndex> ClockDisplay;
+
 #endif
@@ -3,7 +3,33 @@
 #include "ClockDisplayMode.h"
 #include "Pendulum.h"
 
-void ClockDisplayMode::initialize(ClockFrameBuffers &frameBuffers, uint8_t brightness) {
+/**
+ * Draws the pendulum, splitting its brightness linearly between the two LEDs nearest to its position (so their summed light stays constant)
+ * 
+ * @param frameBuffer The pendulum buffer
+ * @param pendulumPosition The pendulum position, in 1/256ths of an LED
+ * @param brightness The brightness of the pendulum
+ * @param inverted If true, the pendulum is drawn as dark LEDs on a lit background
+ */
+inline void drawPendulum(FrameBufferView *frameBuffer, uint16_t pendulumPosition, uint8_t brightness, bool inverted) {
+  uint8_t index = static_cast<uint8_t>(pendulumPosition >> 8);
+  uint8_t fraction = static_cast<uint8_t>(pendulumPosition);
+  uint8_t nextValue = static_cast<uint8_t>((static_cast<uint16_t>(brightness) * fraction) >> 8);
+  uint8_t value = brightness - nextValue;
+  if (inverted) {
+    frameBuffer->setValue(index, brightness - value);
+    if (fraction > 0) {
+      frameBuffer->setValue(index + 1, brightness - nextValue);
+    }
+  } else {
+    frameBuffer->setValue(index, value);
+    if (fraction > 0) {
+      frameBuffer->setValue(index + 1, nextValue);
+    }
+  }
+}
+
+void ClockDisplayMode::initialize(ClockFrameBuffers &frameBuffers, uint8_t /* brightness */) {
   // Initialize basic fade targets which most implementations will use
   frameBuffers.getPendulumBuffer()->setFadeTarget(0);
   frameBuffers.getSecondBuffer()->setFadeTarget(0);
@@ -11,22 +37,22 @@ void ClockDisplayMode::initialize(ClockFrameBuffers &frameBuffers, uint8_t brigh
   frameBuffers.getHourBuffer()->setFadeTarget(0);
 }
 
-void ClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness) {
+void ClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime & /* now */, const uint16_t pendulumPosition, uint8_t brightness) {
   // The base class only handle pendulum updates (this feature is identical for most implementations)
-  frameBuffers.getPendulumBuffer()->setValue(pgm_read_byte(PENDULUM_LED_INDEX + pendulumIndex), brightness);
+  drawPendulum(frameBuffers.getPendulumBuffer(), pendulumPosition, brightness, false);
 }
 
 
-void AnalogClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness) {
-  ClockDisplayMode::update(frameBuffers, now, pendulumIndex, brightness);
+void AnalogClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness) {
+  ClockDisplayMode::update(frameBuffers, now, pendulumPosition, brightness);
   frameBuffers.getSecondBuffer()->setValue(now.second(), brightness);
   frameBuffers.getMinuteBuffer()->setValue(now.minute(), brightness);
   frameBuffers.getHourBuffer()->setValue(now.hour() % 12, brightness);
 }
 
 
-void BinaryClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness) {
-  ClockDisplayMode::update(frameBuffers, now, pendulumIndex, brightness);
+void BinaryClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness) {
+  ClockDisplayMode::update(frameBuffers, now, pendulumPosition, brightness);
   frameBuffers.getSecondBuffer()->setValuesBinaryDisplay(now.second(), 6, 10, false, brightness);
   frameBuffers.getMinuteBuffer()->setValuesBinaryDisplay(now.minute(), 6, 10, false, brightness);
   frameBuffers.getHourBuffer()->setValuesBinaryDisplay(now.hour() % 12, 4, 3, false, brightness);
@@ -39,8 +65,8 @@ void InvertedAnalogClockDisplayMode::initialize(ClockFrameBuffers &frameBuffers,
   frameBuffers.getHourBuffer()->setFadeTarget(brightness);
 }
 
-void InvertedAnalogClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness) {
-  frameBuffers.getPendulumBuffer()->setValue(pgm_read_byte(PENDULUM_LED_INDEX + pendulumIndex), 0);
+void InvertedAnalogClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness) {
+  drawPendulum(frameBuffers.getPendulumBuffer(), pendulumPosition, brightness, true);
   frameBuffers.getSecondBuffer()->setValue(now.second(), 0);
   frameBuffers.getMinuteBuffer()->setValue(now.minute(), 0);
   frameBuffers.getHourBuffer()->setValue(now.hour() % 12, 0);
@@ -58,7 +84,7 @@ inline void drawFilledLine(FrameBufferView *frameBuffer, uint8_t ringValue, uint
     frameBuffer->setFadeTarget(0);
   } else {
     frameBuffer->setFadeTarget(brightness);
-    frameBuffer->setValues(ringValue, 60, 0);
+    frameBuffer->setArc(ringValue, frameBuffer->getCount() - ringValue, 0);
   }
 }
 
@@ -74,19 +100,19 @@ inline void drawUnfilledLine(FrameBufferView *frameBuffer, uint8_t ringValue, ui
     frameBuffer->setFadeTarget(brightness);
   } else {
     frameBuffer->setFadeTarget(0);
-    frameBuffer->setValues(ringValue, 60, brightness);
+    frameBuffer->setArc(ringValue, frameBuffer->getCount() - ringValue, brightness);
   }
 }
 
-void FillClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness) {
-  ClockDisplayMode::update(frameBuffers, now, pendulumIndex, brightness);
+void FillClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness) {
+  ClockDisplayMode::update(frameBuffers, now, pendulumPosition, brightness);
   drawFilledLine(frameBuffers.getSecondBuffer(), now.second(), brightness);
   drawFilledLine(frameBuffers.getMinuteBuffer(), now.minute(), brightness);
   drawFilledLine(frameBuffers.getHourBuffer(), now.hour() % 12, brightness);
 }
 
-void FillUnfillClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness) {
-  ClockDisplayMode::update(frameBuffers, now, pendulumIndex, brightness);
+void FillUnfillClockDisplayMode::update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness) {
+  ClockDisplayMode::update(frameBuffers, now, pendulumPosition, brightness);
 
   if (now.minute() % 2 == 0) {
     drawFilledLine(frameBuffers.getSecondBuffer(), now.second(), brightness);
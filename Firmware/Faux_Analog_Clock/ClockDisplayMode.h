@@ -10,6 +10,8 @@
  */
 class ClockDisplayMode {
 public:
+  virtual ~ClockDisplayMode() {}
+
   /**
    * Initializes the display mode
    */
@@ -17,8 +19,10 @@ public:
 
   /**
    * Updates the display mode with the current time
+   *
+   * @param pendulumPosition The pendulum position, in 1/256ths of an LED (see getPendulumPosition())
    */
-  virtual void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumIndex, uint8_t brightness);
+  virtual void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness);
 };
 
 /**
@@ -26,7 +30,7 @@ public:
  */
 class AnalogClockDisplayMode : public ClockDisplayMode {
 public:
-  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t milliseconds, uint8_t brightness);
+  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness);
 };
 
 /**
@@ -34,7 +38,7 @@ public:
  */
 class BinaryClockDisplayMode : public ClockDisplayMode {
 public:
-  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t milliseconds, uint8_t brightness);
+  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness);
 };
 
 /**
@@ -43,7 +47,7 @@ public:
 class InvertedAnalogClockDisplayMode : public ClockDisplayMode {
 public:
   void initialize(ClockFrameBuffers &frameBuffers, uint8_t brightness);
-  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t milliseconds, uint8_t brightness);
+  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness);
 };
 
 /**
@@ -51,7 +55,7 @@ public:
  */
 class FillClockDisplayMode : public ClockDisplayMode {
 public:
-  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t milliseconds, uint8_t brightness);
+  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness);
 };
 
 /**
@@ -59,7 +63,7 @@ public:
  */
 class FillUnfillClockDisplayMode : public ClockDisplayMode {
 public:
-  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t milliseconds, uint8_t brightness);
+  void update(ClockFrameBuffers &frameBuffers, const DateTime &now, const uint16_t pendulumPosition, uint8_t brightness);
 };
 
 #endif
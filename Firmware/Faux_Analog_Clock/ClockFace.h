@@ -1,18 +1,51 @@
 #ifndef CLOCK_FACE_H
 #define CLOCK_FACE_H
 
-const PROGMEM uint8_t FACE_INNER_HOURLY_BRIGHTNESS[] = {
-  0, 0, 0, 0, 0, 0,
-  255, 255, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0,
-  255, 255, 0, 0, 0, 0
-};
+#include "Arduino.h"
+#include "ConstexprTable.h"
+
+/**
+ * Sunrise/sunset times (minutes after local midnight) used until the GPS has reported a position
+ */
+const uint16_t FACE_DEFAULT_SUNRISE_MINUTE = 420;
+const uint16_t FACE_DEFAULT_SUNSET_MINUTE = 1140;
+
+/**
+ * The number of minutes before and after sunrise/sunset during which the twilight gradient is shown
+ */
+const uint8_t FACE_TWILIGHT_MINUTES = 60;
+
+/**
+ * The number of minutes over which the twilight gradient ramps up (at its start) and down (at its end)
+ */
+const uint8_t FACE_TWILIGHT_RAMP_MINUTES = 30;
 
-const PROGMEM uint8_t FACE_OUTER_HOURLY_BRIGHTNESS[] = {
-  255, 255, 255, 255, 255, 255,
-  0, 0, 255, 255, 255, 255,
-  255, 255, 255, 255, 255, 255,
-  0, 0, 255, 255, 255, 255
+/**
+ * The shape of the twilight gradient ramps (1.0 is linear, higher values start more slowly)
+ */
+constexpr double FACE_TWILIGHT_CURVE = 1.0;
+
+/**
+ * The number of minutes between each entry of the twilight gradient table
+ */
+const uint8_t FACE_TWILIGHT_STEP_MINUTES = 5;
+
+/**
+ * Generates the inner face ring brightness from FACE_TWILIGHT_MINUTES before until FACE_TWILIGHT_MINUTES after a sunrise or sunset.
+ * The outer face ring is lit with the inverse of this value.
+ */
+struct FaceTwilightGradientGenerator {
+  typedef uint8_t Type;
+  static const uint16_t SIZE = 2 * FACE_TWILIGHT_MINUTES / FACE_TWILIGHT_STEP_MINUTES + 1;
+  static constexpr int16_t distance(uint16_t index) {
+    return index * FACE_TWILIGHT_STEP_MINUTES > FACE_TWILIGHT_MINUTES ? index * FACE_TWILIGHT_STEP_MINUTES - FACE_TWILIGHT_MINUTES : FACE_TWILIGHT_MINUTES - index * FACE_TWILIGHT_STEP_MINUTES;
+  }
+  static constexpr Type value(uint16_t index) {
+    return distance(index) <= FACE_TWILIGHT_MINUTES - FACE_TWILIGHT_RAMP_MINUTES ? 255
+      : static_cast<Type>(constexprRound(255 * constexprPow(static_cast<double>(FACE_TWILIGHT_MINUTES - distance(index)) / FACE_TWILIGHT_RAMP_MINUTES, FACE_TWILIGHT_CURVE)));
+  }
 };
 
+typedef ConstexprTable<FaceTwilightGradientGenerator> FaceTwilightGradient;
+
 #endif
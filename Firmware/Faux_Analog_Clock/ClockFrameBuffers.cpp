@@ -1,19 +1,26 @@
 #include "FrameBufferView.h"
 #include "ClockDisplay.h"
+#include "ClockCompositor.h"
 #include "ClockFrameBuffers.h"
 
-ClockFrameBuffers::ClockFrameBuffers(ClockDisplay &clockDisplay) {
-  secondBuffer = clockDisplay.newFrameBufferView(CLOCK_SECONDS_OFFSET, 60);
-  minuteBuffer = clockDisplay.newFrameBufferView(CLOCK_MINUTES_OFFSET, 60);
-  hourBuffer = clockDisplay.newFrameBufferView(CLOCK_HOURS_OFFSET, 12);
-  pendulumBuffer = clockDisplay.newFrameBufferView(CLOCK_PENDULUM_OFFSET, 12);
-  faceInnerRingBuffer = clockDisplay.newFrameBufferView(CLOCK_FACE_INNER_OFFSET, 12);
-  faceOuterRingBuffer = clockDisplay.newFrameBufferView(CLOCK_FACE_OUTER_OFFSET, 12);
-  displayLeftBuffer = clockDisplay.newFrameBufferView(CLOCK_7SEG_LEFT_OFFSET, 7);
-  displayRightBuffer = clockDisplay.newFrameBufferView(CLOCK_7SEG_RIGHT_OFFSET, 7);
+ClockFrameBuffers::ClockFrameBuffers(ClockCompositor &compositor) {
+  baseBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, 0, CLOCK_DISPLAY_LED_COUNT);
+  secondBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, CLOCK_SECONDS_OFFSET, 60);
+  minuteBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, CLOCK_MINUTES_OFFSET, 60);
+  hourBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, CLOCK_HOURS_OFFSET, 12);
+  pendulumBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, CLOCK_PENDULUM_OFFSET, 12);
+  faceInnerRingBuffer = compositor.newLayerView(CLOCK_LAYER_FACE, CLOCK_FACE_INNER_OFFSET, 12);
+  faceOuterRingBuffer = compositor.newLayerView(CLOCK_LAYER_FACE, CLOCK_FACE_OUTER_OFFSET, 12);
+  displayLeftBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, CLOCK_7SEG_LEFT_OFFSET, 7);
+  displayRightBuffer = compositor.newLayerView(CLOCK_LAYER_BASE, CLOCK_7SEG_RIGHT_OFFSET, 7);
+  overlayInnerRingBuffer = compositor.newLayerView(CLOCK_LAYER_OVERLAY, CLOCK_FACE_INNER_OFFSET, 12);
+  overlayOuterRingBuffer = compositor.newLayerView(CLOCK_LAYER_OVERLAY, CLOCK_FACE_OUTER_OFFSET, 12);
+  menuLeftBuffer = compositor.newLayerView(CLOCK_LAYER_MENU, CLOCK_7SEG_LEFT_OFFSET, 7);
+  menuRightBuffer = compositor.newLayerView(CLOCK_LAYER_MENU, CLOCK_7SEG_RIGHT_OFFSET, 7);
 }
 
 ClockFrameBuffers::~ClockFrameBuffers() {
+  delete baseBuffer;
   delete secondBuffer;
   delete minuteBuffer;
   delete hourBuffer;
@@ -22,6 +29,10 @@ ClockFrameBuffers::~ClockFrameBuffers() {
   delete faceOuterRingBuffer;
   delete displayLeftBuffer;
   delete displayRightBuffer;
+  delete overlayInnerRingBuffer;
+  delete overlayOuterRingBuffer;
+  delete menuLeftBuffer;
+  delete menuRightBuffer;
 }
 
 void ClockFrameBuffers::updateFade() {
@@ -45,3 +56,14 @@ void ClockFrameBuffers::accelerateFadeToEnd() {
   displayLeftBuffer->accelerateFadeToEnd();
   displayRightBuffer->accelerateFadeToEnd();
 }
+
+void ClockFrameBuffers::enableTimedFade() {
+  secondBuffer->enableTimedFade();
+  minuteBuffer->enableTimedFade();
+  hourBuffer->enableTimedFade();
+  pendulumBuffer->enableTimedFade();
+  faceInnerRingBuffer->enableTimedFade();
+  faceOuterRingBuffer->enableTimedFade();
+  displayLeftBuffer->enableTimedFade();
+  displayRightBuffer->enableTimedFade();
+}
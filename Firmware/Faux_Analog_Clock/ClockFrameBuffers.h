@@ -3,6 +3,7 @@
 
 #include "FrameBufferView.h"
 #include "ClockDisplay.h"
+#include "ClockCompositor.h"
 
 /**
  * Initializes various frame buffers for the clock display
@@ -10,9 +11,9 @@
 class ClockFrameBuffers {
 public:
   /**
-   * Initializes a set of clock frame buffers from the given clock display
+   * Initializes a set of clock frame buffers on the layers of the given compositor
    */
-  ClockFrameBuffers(ClockDisplay &clockDisplay);
+  ClockFrameBuffers(ClockCompositor &compositor);
 
   /**
    * Deletes all frame buffers
@@ -22,10 +23,15 @@ public:
   // Utility functions to update the underlying buffers
   void updateFade();
   void accelerateFadeToEnd();
+  void enableTimedFade();
 
   /**
    * The following are simple getters for the frame buffers
    */
+  inline FrameBufferView *getBaseBuffer() {
+    return baseBuffer;
+  }
+
   inline FrameBufferView *getSecondBuffer() {
     return secondBuffer;
   }
@@ -58,7 +64,24 @@ public:
     return displayRightBuffer;
   }
 
+  inline FrameBufferView *getOverlayInnerRingBuffer() {
+    return overlayInnerRingBuffer;
+  }
+
+  inline FrameBufferView *getOverlayOuterRingBuffer() {
+    return overlayOuterRingBuffer;
+  }
+
+  inline FrameBufferView *getMenuLeftBuffer() {
+    return menuLeftBuffer;
+  }
+
+  inline FrameBufferView *getMenuRightBuffer() {
+    return menuRightBuffer;
+  }
+
 private:
+  FrameBufferView *baseBuffer = NULL; // The whole base layer (for animations which take over the display)
   FrameBufferView *secondBuffer = NULL;
   FrameBufferView *minuteBuffer = NULL;
   FrameBufferView *hourBuffer = NULL;
@@ -67,6 +90,10 @@ private:
   FrameBufferView *faceOuterRingBuffer = NULL;
   FrameBufferView *displayLeftBuffer = NULL;
   FrameBufferView *displayRightBuffer = NULL;
+  FrameBufferView *overlayInnerRingBuffer = NULL;
+  FrameBufferView *overlayOuterRingBuffer = NULL;
+  FrameBufferView *menuLeftBuffer = NULL;
+  FrameBufferView *menuRightBuffer = NULL;
 };
 
 #endif
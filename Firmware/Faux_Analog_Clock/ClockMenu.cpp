@@ -1,6 +1,8 @@
 #include "Arduino.h"
 #include "ClockOptions.h"
 #include "ClockMenu.h"
+#include "ClockTime.h"
+#include "Trace.h"
 
 
 /*
@@ -13,6 +15,7 @@
  *   "Fd" = Fade effects
  *   "br" = Brightness
  *   "nb" = Night brightness (multiplied by brightness)
+ *   "Ab" = Automatic brightness (ambient light sensor)
  *   "dY" = Display mode
  *   "UT" = Utilities
  *   "Pd" = Pendulum period
@@ -36,7 +39,11 @@
  *   Clock LED overall brightness, from "1" (10%) to "10" (100%)
  * 
  * Night brightness ("nb") menu:
- *   Clock LED brightness at night (between 6 PM and 6 AM), from "1" (10% of normal brightness) to "10" (100% of normal brightness)
+ *   Clock LED brightness at night (from sunset until an hour before sunrise), from "1" (10% of normal brightness) to "10" (100% of normal brightness),
+ *   or "oF" (the display is dark and the CPU sleeps through the night)
+ *   
+ * Automatic brightness ("Ab") menu:
+ *   Whether the brightness follows the ambient light sensor ("Y"), scaling between the night brightness and the brightness, or the time of day ("n")
  *   
  * Display mode ("dY") menu:
  *   "An" = Analog display mode (classic analog clock face)
@@ -53,51 +60,91 @@
  *   "RS" = Reset time using GPS
  *   "L1" = LED test 1 (light all LEDs at full intensity)
  *   "L2" = LED test 2 (light each LED at full intensity in sequence)
+ *   "CP" = CPU idle percentage
+ *   "oR" = Task deadline overrun count
+ *   "tr" = Trace log readout
+ *   "CA" = LED calibration (step through the LEDs, dimming each to match the previous one)
+ *   "rA" = SRAM usage (minimum free bytes, stack and heap high-water marks)
+ *   "Hn" = Watchdog stall report (stalls and the resets they caused)
  */
 
 /*
- *  This is ugly, but please bear with me. 
- *  These strings are pairs of ASCII characters to be displayed on the 7-segment displays. 
- *  The length of these strings must be twice the length of each sub-menu (i.e. one character for each digit for each menu item). 
- *  Indices (MSNybble):                                         0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1 1 1 1 1 1 1 1 1 1 1
- *  Indices (LSNybble):                                         0 1 2 3 4 5 6 7 8 9 A B C D E F 0 1 2 3 4 5 6 7 8 9 A
+ * Sub-menu item text: pairs of ASCII characters to be displayed on the 7-segment displays (one character for each digit for each item).
+ *  Indices (MSNybble):                                0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1 1 1 1 1 1 1 1 1 1 1
+ *  Indices (LSNybble):                                0 1 2 3 4 5 6 7 8 9 A B C D E F 0 1 2 3 4 5 6 7 8 9 A
+ */
+const PROGMEM char CLOCK_MENU_ITEMS_TIMEZONE[]        = "-C-b-A-9-8-7-6-5-4-3-2-1 0 1 2 3 4 5 6 7 8 9 A b C d E";
+const PROGMEM char CLOCK_MENU_ITEMS_BOOLEAN[]         = " n Y";
+const PROGMEM char CLOCK_MENU_ITEMS_FACE_EFFECTS[]    = "onouinbo";
+const PROGMEM char CLOCK_MENU_ITEMS_DECIMAL[]         = " 1 2 3 4 5 6 7 8 910";
+const PROGMEM char CLOCK_MENU_ITEMS_OFF_DECIMAL[]     = "oF 1 2 3 4 5 6 7 8 910";
+const PROGMEM char CLOCK_MENU_ITEMS_DISPLAY_MODE[]    = "AnbnF1F2In";
+const PROGMEM char CLOCK_MENU_ITEMS_PENDULUM_PERIOD[] = "FASL";
+const PROGMEM char CLOCK_MENU_ITEMS_UTILITIES[]       = "RSL1L2CPoRtrCArAHn";
+
+/*
+ * Full names of the main menu options, scrolled across the 7-segment displays (their first two characters are shown first,
+ * so they start with the option's code)
+ */
+const PROGMEM char CLOCK_MENU_NAME_TIMEZONE[]         = "TZ TIME ZONE";
+const PROGMEM char CLOCK_MENU_NAME_DST[]              = "dS DAYLIGHT SAVING";
+const PROGMEM char CLOCK_MENU_NAME_FACE_EFFECTS[]     = "FE FACE EFFECTS";
+const PROGMEM char CLOCK_MENU_NAME_FADE_EFFECTS[]     = "Fd FADE EFFECTS";
+const PROGMEM char CLOCK_MENU_NAME_BRIGHTNESS[]       = "br BRIGHTNESS";
+const PROGMEM char CLOCK_MENU_NAME_NIGHT_BRIGHTNESS[] = "nb NIGHT BRIGHTNESS";
+const PROGMEM char CLOCK_MENU_NAME_AUTO_BRIGHTNESS[]  = "Ab AUTO BRIGHTNESS";
+const PROGMEM char CLOCK_MENU_NAME_DISPLAY_MODE[]     = "dY DISPLAY MODE";
+const PROGMEM char CLOCK_MENU_NAME_PENDULUM_PERIOD[]  = "Pd PENDULUM PERIOD";
+const PROGMEM char CLOCK_MENU_NAME_UTILITIES[]        = "UT UTILITIES";
+
+/**
+ * How an option value maps to a sub-menu item (items are numbered from 1)
  */
-const PROGMEM char CLOCK_SUBMENU_TEXT[]                      = "TZdSFEFdbrnbdYPdUT";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_TIMEZONE[]        = "-C-b-A-9-8-7-6-5-4-3-2-1 0 1 2 3 4 5 6 7 8 9 A b C d E";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_BOOLEAN[]         = " n Y";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_FACE_EFFECTS[]    = "onouinbo";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_DECIMAL[]         = " 1 2 3 4 5 6 7 8 910";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_DISPLAY_MODE[]    = "AnbnF1F2In";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_PENDULUM_PERIOD[] = "FASL";
-const PROGMEM char CLOCK_SUBMENU_ITEM_TEXT_UTILITIES[]       = "RSL1L2";
-
-constexpr uint8_t CLOCK_SUBMENU_COUNT = strlen(CLOCK_SUBMENU_TEXT) / 2;
-constexpr uint8_t CLOCK_SUBMENU_LENGTH[CLOCK_SUBMENU_COUNT] = {
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_TIMEZONE) / 2,        // Timezone
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_BOOLEAN) / 2,         // DST
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_FACE_EFFECTS) / 2,    // Face Effects
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_BOOLEAN) / 2,         // Fade Effects
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_DECIMAL) / 2,         // Brightness
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_DECIMAL) / 2,         // Night Brightness
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_DISPLAY_MODE) / 2,    // Display mode
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_PENDULUM_PERIOD) / 2, // Pendulum period
-  strlen(CLOCK_SUBMENU_ITEM_TEXT_UTILITIES) / 2        // Utilities
+const uint8_t CLOCK_MENU_MAPPING_OFFSET = 0;     // item = value + itemOffset (modulo 256, so signed values work)
+const uint8_t CLOCK_MENU_MAPPING_BRIGHTNESS = 1; // item = value scaled from 0..255 to 0..(itemCount - itemOffset), + itemOffset
+
+/**
+ * A main menu option
+ */
+struct ClockMenuOption {
+  const char *name;     // Full name (see above)
+  const char *items;    // Sub-menu item text
+  uint8_t itemCount;
+  uint8_t option;       // The option set by the sub-menu (see CLOCK_OPTION_*)
+  uint8_t mapping;      // See CLOCK_MENU_MAPPING_*
+  uint8_t itemOffset;
 };
 
-const char * const CLOCK_SUBMENU_ITEM_TEXT[CLOCK_SUBMENU_COUNT] = {
-  CLOCK_SUBMENU_ITEM_TEXT_TIMEZONE,
-  CLOCK_SUBMENU_ITEM_TEXT_BOOLEAN,
-  CLOCK_SUBMENU_ITEM_TEXT_FACE_EFFECTS,
-  CLOCK_SUBMENU_ITEM_TEXT_BOOLEAN,
-  CLOCK_SUBMENU_ITEM_TEXT_DECIMAL,
-  CLOCK_SUBMENU_ITEM_TEXT_DECIMAL,
-  CLOCK_SUBMENU_ITEM_TEXT_DISPLAY_MODE,
-  CLOCK_SUBMENU_ITEM_TEXT_PENDULUM_PERIOD,
-  CLOCK_SUBMENU_ITEM_TEXT_UTILITIES
+#define CLOCK_MENU_ITEM_COUNT(items) ((sizeof(items) - 1) / 2)
+
+/*
+ * The main menu, in order. Entering an option opens its sub-menu at the item for the option's current value (or the first item
+ * if the value has no item); entering an item sets the option to that item's value.
+ */
+const PROGMEM ClockMenuOption CLOCK_MENU_OPTIONS[] = {
+  { CLOCK_MENU_NAME_TIMEZONE,         CLOCK_MENU_ITEMS_TIMEZONE,        CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_TIMEZONE),        CLOCK_OPTION_TIMEZONE,           CLOCK_MENU_MAPPING_OFFSET,     13 },
+  { CLOCK_MENU_NAME_DST,              CLOCK_MENU_ITEMS_BOOLEAN,         CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_BOOLEAN),         CLOCK_OPTION_DST,                CLOCK_MENU_MAPPING_OFFSET,     1 },
+  { CLOCK_MENU_NAME_FACE_EFFECTS,     CLOCK_MENU_ITEMS_FACE_EFFECTS,    CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_FACE_EFFECTS),    CLOCK_OPTION_FACE_EFFECTS,       CLOCK_MENU_MAPPING_OFFSET,     1 },
+  { CLOCK_MENU_NAME_FADE_EFFECTS,     CLOCK_MENU_ITEMS_BOOLEAN,         CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_BOOLEAN),         CLOCK_OPTION_FADE_EFFECTS,       CLOCK_MENU_MAPPING_OFFSET,     1 },
+  { CLOCK_MENU_NAME_BRIGHTNESS,       CLOCK_MENU_ITEMS_DECIMAL,         CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_DECIMAL),         CLOCK_OPTION_DAYTIME_BRIGHTNESS, CLOCK_MENU_MAPPING_BRIGHTNESS, 0 },
+  { CLOCK_MENU_NAME_NIGHT_BRIGHTNESS, CLOCK_MENU_ITEMS_OFF_DECIMAL,     CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_OFF_DECIMAL),     CLOCK_OPTION_NIGHT_BRIGHTNESS,   CLOCK_MENU_MAPPING_BRIGHTNESS, 1 },
+  { CLOCK_MENU_NAME_AUTO_BRIGHTNESS,  CLOCK_MENU_ITEMS_BOOLEAN,         CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_BOOLEAN),         CLOCK_OPTION_AUTO_BRIGHTNESS,    CLOCK_MENU_MAPPING_OFFSET,     1 },
+  { CLOCK_MENU_NAME_DISPLAY_MODE,     CLOCK_MENU_ITEMS_DISPLAY_MODE,    CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_DISPLAY_MODE),    CLOCK_OPTION_DISPLAY_MODE,       CLOCK_MENU_MAPPING_OFFSET,     1 },
+  { CLOCK_MENU_NAME_PENDULUM_PERIOD,  CLOCK_MENU_ITEMS_PENDULUM_PERIOD, CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_PENDULUM_PERIOD), CLOCK_OPTION_PENDULUM_PERIOD,    CLOCK_MENU_MAPPING_OFFSET,     0 },
+  { CLOCK_MENU_NAME_UTILITIES,        CLOCK_MENU_ITEMS_UTILITIES,       CLOCK_MENU_ITEM_COUNT(CLOCK_MENU_ITEMS_UTILITIES),       CLOCK_OPTION_UTILITY_MODE,       CLOCK_MENU_MAPPING_OFFSET,     0 }
 };
 
+const uint8_t CLOCK_MENU_OPTION_COUNT = sizeof(CLOCK_MENU_OPTIONS) / sizeof(CLOCK_MENU_OPTIONS[0]);
 
-ClockMenu::ClockMenu(ClockOptions &options, uint8_t selectButtonMask, uint8_t enterButtonMask, uint32_t menuTimeoutMilliseconds, uint32_t backButtonLongPressLength) : options(options) {
+/**
+ * Reads a main menu option (1..CLOCK_MENU_OPTION_COUNT) from flash
+ */
+static inline void readMenuOption(uint8_t mainMenuIndex, ClockMenuOption &option) {
+  memcpy_P(&option, CLOCK_MENU_OPTIONS + mainMenuIndex - 1, sizeof(ClockMenuOption));
+}
+
+
+ClockMenu::ClockMenu(ClockOptions &options, uint8_t selectButtonMask, uint8_t enterButtonMask, uint32_t menuTimeoutMilliseconds, uint32_t backButtonLongPressLength) : options(options), buttonInput(selectButtonMask | enterButtonMask) {
   this->selectButtonMask = selectButtonMask;
   this->enterButtonMask = enterButtonMask;
   
@@ -121,16 +168,14 @@ ClockMenu::ClockMenu(ClockOptions &options, uint8_t selectButtonMask, uint8_t en
 }
 
 void ClockMenu::begin() {
-  DDRB &= ~(selectButtonMask | enterButtonMask);
-  PORTB |= selectButtonMask | enterButtonMask;
+  buttonInput.begin();
 
   lastSelectButtonPressed = false;
   lastEnterButtonPressed = false;
   currentSelectButtonPressed = false;
   currentEnterButtonPressed = false;
 
-  firstRead = true;
-  lastButtonCheckMillis = 0;
+  lastButtonCheckMillis = clockMillis();
 }
 
 void ClockMenu::update() {
@@ -145,12 +190,16 @@ void ClockMenu::update() {
       // If the enter button was just pressed, enter the submenu or change the config option
       handleEnterButtonPress();
     }
-  } else {
+  } else if (isOpen()) {
     // Kill the menu if it's been too long since the last button press
     exitMenu();
   }
 }
 
+void ClockMenu::updateButtons() {
+  readButtons();
+}
+
 bool ClockMenu::isOpen() const {
   return currentMainMenuIndex > 0;
 }
@@ -159,6 +208,13 @@ const char *ClockMenu::getMenuText() const {
   return menuTextBuffer;
 }
 
+const char *ClockMenu::getMenuName() const {
+  if (currentMainMenuIndex > 0 && currentSubMenuIndex == 0) {
+    return reinterpret_cast<const char *>(pgm_read_ptr(&CLOCK_MENU_OPTIONS[currentMainMenuIndex - 1].name));
+  }
+  return NULL;
+}
+
 bool ClockMenu::isSelectPressed() const {
   return currentSelectButtonPressed;
 }
@@ -172,40 +228,43 @@ void ClockMenu::readButtons() {
   lastSelectButtonPressed = currentSelectButtonPressed;
   lastEnterButtonPressed = currentEnterButtonPressed;
   
-  uint32_t currentMillis = millis();
+  uint32_t currentMillis = clockMillis();
   uint32_t intervalMillis = currentMillis - lastButtonCheckMillis;
-  if (firstRead || (intervalMillis >= DEBOUNCE_INTERVAL)) {
-    currentSelectButtonPressed = (PINB & selectButtonMask) == 0;
-    currentEnterButtonPressed = (PINB & enterButtonMask) == 0;
-    lastButtonCheckMillis = currentMillis;
-
-    // Check for long press to back out of the menu
-    longPressingSelect = longPressingSelect && currentSelectButtonPressed;
-    if (currentSelectButtonPressed && !lastSelectButtonPressed) {
-      selectButtonDownMillis = currentMillis;
-      longPressingSelect = true;
-    } else if (longPressingSelect && (currentMillis - selectButtonDownMillis >= backButtonLongPressLength)) {
-      if (currentSubMenuIndex > 0) {
-        currentSubMenuIndex = 0;
-        timeoutCounter = menuTimeoutMilliseconds;
-      } else {
-        exitMenu();
-      }
-
-      // Refresh the menu display text
-      refreshMenuTextBuffer();
-      
-      longPressingSelect = false;
-    }
+  lastButtonCheckMillis = currentMillis;
+
+  // Take one debounced change per call, so that update() sees both edges of a press shorter than its period
+  ButtonEvent event;
+  bool buttonsChanged = buttonInput.readEvent(event);
+  if (buttonsChanged) {
+    currentSelectButtonPressed = (event.pressed & selectButtonMask) != 0;
+    currentEnterButtonPressed = (event.pressed & enterButtonMask) != 0;
+    TRACE(TRACE_EVENT_BUTTON_CHANGE, (currentSelectButtonPressed ? 1 : 0) | (currentEnterButtonPressed ? 2 : 0));
+  }
 
-    // Check for timeout
-    if ((currentSelectButtonPressed != lastSelectButtonPressed) || (currentEnterButtonPressed != lastEnterButtonPressed)) {
+  // Check for long press to back out of the menu (timed from the edge, not from when it was read)
+  longPressingSelect = longPressingSelect && currentSelectButtonPressed;
+  if (currentSelectButtonPressed && !lastSelectButtonPressed) {
+    selectButtonDownMillis = event.millis;
+    longPressingSelect = true;
+  } else if (longPressingSelect && (currentMillis - selectButtonDownMillis >= backButtonLongPressLength)) {
+    if (currentSubMenuIndex > 0) {
+      currentSubMenuIndex = 0;
       timeoutCounter = menuTimeoutMilliseconds;
     } else {
-      timeoutCounter -= min(timeoutCounter, intervalMillis);
+      exitMenu();
     }
 
-    firstRead = false;
+    // Refresh the menu display text
+    refreshMenuTextBuffer();
+    
+    longPressingSelect = false;
+  }
+
+  // Check for timeout
+  if (buttonsChanged) {
+    timeoutCounter = menuTimeoutMilliseconds;
+  } else {
+    timeoutCounter -= min(timeoutCounter, intervalMillis);
   }
 }
 
@@ -220,13 +279,13 @@ void ClockMenu::handleSelectButtonPress() {
   } else if (currentSubMenuIndex == 0) {
     // If the menu is already open, but no sub-menu is open, advance to the next sub-menu
     ++currentMainMenuIndex;
-    if (currentMainMenuIndex > CLOCK_SUBMENU_COUNT) {
+    if (currentMainMenuIndex > CLOCK_MENU_OPTION_COUNT) {
       currentMainMenuIndex = 1;
     }
   } else {
     // If a sub-menu is open, advance to the next item in the sub-menu
     ++currentSubMenuIndex;
-    if (currentSubMenuIndex > CLOCK_SUBMENU_LENGTH[currentMainMenuIndex - 1]) {
+    if (currentSubMenuIndex > pgm_read_byte(&CLOCK_MENU_OPTIONS[currentMainMenuIndex - 1].itemCount)) {
       currentSubMenuIndex = 1;
     }
   }
@@ -244,70 +303,18 @@ void ClockMenu::handleEnterButtonPress() {
     currentMainMenuIndex = 1;
     currentSubMenuIndex = 0;
   } else if (currentSubMenuIndex == 0) {
-    // If the main menu is already open, enter the selected sub-menu at the correct option index
-    switch(currentMainMenuIndex) {
-      case 1: // Timezone
-        currentSubMenuIndex = static_cast<uint8_t>(options.getTimezone() + 13);
-        break;
-      case 2: // DST
-        currentSubMenuIndex = options.getDST() ? 2 : 1;
-        break;
-      case 3: // Face effects
-        currentSubMenuIndex = options.getFaceEffects() + 1;
-        break;
-      case 4: // Fade effects
-        currentSubMenuIndex = options.getFadeEffectsEnabled() ? 2 : 1;
-        break;
-      case 5: // Brightness
-        currentSubMenuIndex = mapBrightnessOption(options.getDaytimeBrightness(), 255, 10);
-        break;
-      case 6: // Night brightness
-        currentSubMenuIndex = mapBrightnessOption(options.getNightBrightness(), 255, 10);
-        break;
-      case 7: // Display mode
-        currentSubMenuIndex = options.getDisplayMode() + 1;
-        break;
-      case 8: // Pendulum period
-        currentSubMenuIndex = options.getPendulumPeriod();
-        break;
-      case 9: // Utilities
-        currentSubMenuIndex = 1;
-      default: // Invalid option
-        break;
+    // If the main menu is already open, enter the selected sub-menu at the item for the current value
+    ClockMenuOption option;
+    readMenuOption(currentMainMenuIndex, option);
+    currentSubMenuIndex = getMenuItem(option.mapping, option.itemOffset, option.itemCount, options.getOption(option.option));
+    if (currentSubMenuIndex < 1 || currentSubMenuIndex > option.itemCount) {
+      currentSubMenuIndex = 1;
     }
   } else {
-    // If the sub-menu is already open, set a config option
-    switch(currentMainMenuIndex) {
-      case 1: // Timezone
-        options.setTimezone(static_cast<int8_t>(currentSubMenuIndex) - static_cast<int8_t>(13));
-        break;
-      case 2: // DST
-        options.setDST(currentSubMenuIndex == 2);
-        break;
-      case 3: // Face effects
-        options.setFaceEffects(currentSubMenuIndex - 1);
-        break;
-      case 4: // Fade effects
-        options.setFadeEffectsEnabled(currentSubMenuIndex == 2);
-        break;
-      case 5: // Brightness
-        options.setDaytimeBrightness(mapBrightnessOption(currentSubMenuIndex, 10, 255));
-        break;
-      case 6: // Night brightness
-        options.setNightBrightness(mapBrightnessOption(currentSubMenuIndex, 10, 255));
-        break;
-      case 7: // Display mode
-        options.setDisplayMode(currentSubMenuIndex - 1);
-        break;
-      case 8:
-        options.setPendulumPeriod(currentSubMenuIndex);
-        break;
-      case 9: // Utilities
-        options.setCurrentUtilityMode(currentSubMenuIndex);
-        break;
-      default: // Invalid option
-        break;
-    }
+    // If the sub-menu is already open, set the option to the selected item's value
+    ClockMenuOption option;
+    readMenuOption(currentMainMenuIndex, option);
+    options.setOption(option.option, getMenuItemValue(option.mapping, option.itemOffset, option.itemCount, currentSubMenuIndex));
 
     // Go back to the main menu
     currentSubMenuIndex = 0;
@@ -322,12 +329,12 @@ void ClockMenu::refreshMenuTextBuffer() {
     const char *source;
     uint8_t offset;
     if (currentSubMenuIndex == 0) {
-      // Inside the main menu
-      source = CLOCK_SUBMENU_TEXT;
-      offset = (currentMainMenuIndex - 1) << 1;
+      // Inside the main menu (the code is the start of the option's name)
+      source = reinterpret_cast<const char *>(pgm_read_ptr(&CLOCK_MENU_OPTIONS[currentMainMenuIndex - 1].name));
+      offset = 0;
     } else {
       // Inside a sub-menu
-      source = CLOCK_SUBMENU_ITEM_TEXT[currentMainMenuIndex - 1];
+      source = reinterpret_cast<const char *>(pgm_read_ptr(&CLOCK_MENU_OPTIONS[currentMainMenuIndex - 1].items));
       offset = (currentSubMenuIndex - 1) << 1;
     }
     menuTextBuffer[0] = pgm_read_byte(source + offset);
@@ -343,6 +350,20 @@ void ClockMenu::exitMenu() {
   options.saveOptions();
 }
 
+uint8_t ClockMenu::getMenuItem(uint8_t mapping, uint8_t itemOffset, uint8_t itemCount, uint8_t value) {
+  if (mapping == CLOCK_MENU_MAPPING_BRIGHTNESS) {
+    return mapBrightnessOption(value, 255, itemCount - itemOffset) + itemOffset;
+  }
+  return static_cast<uint8_t>(value + itemOffset);
+}
+
+uint8_t ClockMenu::getMenuItemValue(uint8_t mapping, uint8_t itemOffset, uint8_t itemCount, uint8_t item) {
+  if (mapping == CLOCK_MENU_MAPPING_BRIGHTNESS) {
+    return mapBrightnessOption(item - itemOffset, itemCount - itemOffset, 255);
+  }
+  return static_cast<uint8_t>(item - itemOffset);
+}
+
 uint8_t ClockMenu::mapBrightnessOption(uint8_t option, uint8_t fromRange, uint8_t toRange) {
   uint16_t numerator = static_cast<uint16_t>(option) * static_cast<uint16_t>(toRange);
   uint16_t result = numerator / static_cast<uint16_t>(fromRange);
@@ -3,8 +3,7 @@
 
 #include "Arduino.h"
 #include "ClockOptions.h"
-
-const uint32_t DEBOUNCE_INTERVAL = 50;
+#include "ButtonInput.h"
 
 class ClockMenu {
 public:
@@ -29,6 +28,11 @@ public:
    */
   void update();
 
+  /**
+   * Reads the buttons without acting on them (for utility modes which use the buttons themselves)
+   */
+  void updateButtons();
+
   /**
    * Determines whether the menu is currently open
    */
@@ -39,6 +43,11 @@ public:
    */
   const char *getMenuText() const;
 
+  /**
+   * Gets the full name of the current main menu option (a PROGMEM string), or NULL inside a sub-menu or with the menu closed
+   */
+  const char *getMenuName() const;
+
   /**
    * Returns whether the "Select" button is currently being pressed
    */
@@ -54,6 +63,7 @@ private:
   
   uint8_t selectButtonMask;
   uint8_t enterButtonMask;
+  ButtonInput buttonInput;
 
   uint32_t menuTimeoutMilliseconds;
   uint32_t backButtonLongPressLength;
@@ -64,7 +74,6 @@ private:
   bool currentEnterButtonPressed;
   bool longPressingSelect;
 
-  bool firstRead;
   uint32_t lastButtonCheckMillis;
   uint32_t selectButtonDownMillis;
   uint32_t timeoutCounter;
@@ -75,7 +84,7 @@ private:
   char menuTextBuffer[3];
 
   /**
-   * Reads the state of the buttons
+   * Reads the next change of the buttons' state, if any
    */
   void readButtons();
 
@@ -99,6 +108,21 @@ private:
    */
   void exitMenu();
 
+  /**
+   * Gets the sub-menu item (from 1) for an option value
+   * 
+   * @param mapping How values map to items (see CLOCK_MENU_MAPPING_*)
+   * @param itemOffset The item offset of the mapping
+   * @param itemCount The number of items in the sub-menu
+   * @param value The option value
+   */
+  uint8_t getMenuItem(uint8_t mapping, uint8_t itemOffset, uint8_t itemCount, uint8_t value);
+
+  /**
+   * Gets the option value for a sub-menu item (the inverse of getMenuItem())
+   */
+  uint8_t getMenuItemValue(uint8_t mapping, uint8_t itemOffset, uint8_t itemCount, uint8_t item);
+
   /**
    * Scales a brightness option from the 0..fromRange range to the 0..toRange range
    * 
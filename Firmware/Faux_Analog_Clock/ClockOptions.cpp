@@ -1,8 +1,9 @@
 #include "Arduino.h"
 #include "ClockOptions.h"
 #include "EEPROM.h"
+#include "Trace.h"
 
-const uint8_t CONFIG_VERSION = 1;
+const uint8_t CONFIG_VERSION = 2;
 
 ClockOptions::ClockOptions() {
   loadOptions();
@@ -42,6 +43,11 @@ void ClockOptions::setNightBrightness(uint8_t value) {
   changed = true;
 }
 
+void ClockOptions::setAutoBrightnessEnabled(bool enabled) {
+  autoBrightnessEnabled = enabled;
+  changed = true;
+}
+
 void ClockOptions::setDisplayMode(uint8_t mode) {
   this->displayMode = mode;
   changed = true;
@@ -49,6 +55,7 @@ void ClockOptions::setDisplayMode(uint8_t mode) {
 
 void ClockOptions::setPendulumPeriod(uint8_t numSeconds) {
   this->pendulumPeriod = max(numSeconds, 1);
+  changed = true;
 }
 
 void ClockOptions::setCurrentUtilityMode(uint8_t mode) {
@@ -81,6 +88,10 @@ uint8_t ClockOptions::getNightBrightness() const {
   return nightBrightness;
 }
 
+bool ClockOptions::getAutoBrightnessEnabled() const {
+  return autoBrightnessEnabled;
+}
+
 uint8_t ClockOptions::getCurrentUtilityMode() const {
   return currentUtilityMode;
 }
@@ -104,7 +115,73 @@ bool ClockOptions::getOptionsChanged() {
 }
 
 
+void ClockOptions::setOption(uint8_t option, uint8_t value) {
+  switch (option) {
+    case CLOCK_OPTION_TIMEZONE:
+      setTimezone(static_cast<int8_t>(value));
+      break;
+    case CLOCK_OPTION_DST:
+      setDST(value != 0);
+      break;
+    case CLOCK_OPTION_FACE_EFFECTS:
+      setFaceEffects(value);
+      break;
+    case CLOCK_OPTION_FADE_EFFECTS:
+      setFadeEffectsEnabled(value != 0);
+      break;
+    case CLOCK_OPTION_DAYTIME_BRIGHTNESS:
+      setDaytimeBrightness(value);
+      break;
+    case CLOCK_OPTION_NIGHT_BRIGHTNESS:
+      setNightBrightness(value);
+      break;
+    case CLOCK_OPTION_AUTO_BRIGHTNESS:
+      setAutoBrightnessEnabled(value != 0);
+      break;
+    case CLOCK_OPTION_DISPLAY_MODE:
+      setDisplayMode(value);
+      break;
+    case CLOCK_OPTION_PENDULUM_PERIOD:
+      setPendulumPeriod(value);
+      break;
+    case CLOCK_OPTION_UTILITY_MODE:
+      setCurrentUtilityMode(value);
+      break;
+    default: // Invalid option
+      break;
+  }
+}
+
+uint8_t ClockOptions::getOption(uint8_t option) const {
+  switch (option) {
+    case CLOCK_OPTION_TIMEZONE:
+      return static_cast<uint8_t>(timezone);
+    case CLOCK_OPTION_DST:
+      return dst ? 1 : 0;
+    case CLOCK_OPTION_FACE_EFFECTS:
+      return faceEffects;
+    case CLOCK_OPTION_FADE_EFFECTS:
+      return fadeEffectsEnabled ? 1 : 0;
+    case CLOCK_OPTION_DAYTIME_BRIGHTNESS:
+      return daytimeBrightness;
+    case CLOCK_OPTION_NIGHT_BRIGHTNESS:
+      return nightBrightness;
+    case CLOCK_OPTION_AUTO_BRIGHTNESS:
+      return autoBrightnessEnabled ? 1 : 0;
+    case CLOCK_OPTION_DISPLAY_MODE:
+      return displayMode;
+    case CLOCK_OPTION_PENDULUM_PERIOD:
+      return pendulumPeriod;
+    case CLOCK_OPTION_UTILITY_MODE:
+      return currentUtilityMode;
+    default: // Invalid option
+      return 0;
+  }
+}
+
+// Options are stored from address 0 (the LED trim table starts at CLOCK_DISPLAY_TRIM_EEPROM_ADDRESS)
 void ClockOptions::saveOptions() {
+  TRACE(TRACE_EVENT_OPTIONS_SAVE_BEGIN, 0);
   EEPROM.put(0, CONFIG_VERSION);
   EEPROM.put(1, timezone);
   EEPROM.put(2, dst);
@@ -114,6 +191,8 @@ void ClockOptions::saveOptions() {
   EEPROM.put(6, nightBrightness);
   EEPROM.put(7, displayMode);
   EEPROM.put(8, pendulumPeriod);
+  EEPROM.put(9, autoBrightnessEnabled);
+  TRACE(TRACE_EVENT_OPTIONS_SAVE_END, 0);
 }
 
 
@@ -131,6 +210,7 @@ void ClockOptions::loadOptions() {
     nightBrightness = 255;
     displayMode = CLOCK_DISPLAY_MODE_ANALOG;
     pendulumPeriod = 1;
+    autoBrightnessEnabled = false;
   } else {
     EEPROM.get(1, timezone);
     EEPROM.get(2, dst);
@@ -140,6 +220,13 @@ void ClockOptions::loadOptions() {
     EEPROM.get(6, nightBrightness);
     EEPROM.get(7, displayMode);
     EEPROM.get(8, pendulumPeriod);
+
+    // Options added in version 2
+    if (version >= 2) {
+      EEPROM.get(9, autoBrightnessEnabled);
+    } else {
+      autoBrightnessEnabled = false;
+    }
   }
   updatePremultipliedNightBrightness();
 }
@@ -30,6 +30,12 @@ const uint8_t UTILITY_MODE_NONE = 0;
 const uint8_t UTILITY_MODE_RESET_TIME = 1;
 const uint8_t UTILITY_MODE_LED_TEST_1 = 2;
 const uint8_t UTILITY_MODE_LED_TEST_2 = 3;
+const uint8_t UTILITY_MODE_IDLE_METER = 4;
+const uint8_t UTILITY_MODE_OVERRUN_METER = 5;
+const uint8_t UTILITY_MODE_TRACE_READOUT = 6;
+const uint8_t UTILITY_MODE_LED_CALIBRATION = 7;
+const uint8_t UTILITY_MODE_MEMORY_METER = 8;
+const uint8_t UTILITY_MODE_STALL_REPORT = 9;
 
 /**
  * Display mode values
@@ -40,6 +46,20 @@ const uint8_t CLOCK_DISPLAY_MODE_FILL = 2;
 const uint8_t CLOCK_DISPLAY_MODE_FILL_UNFILL = 3;
 const uint8_t CLOCK_DISPLAY_MODE_INVERTED_ANALOG = 4;
 
+/**
+ * Option IDs, for getting and setting options generically (see ClockOptions::getOption())
+ */
+const uint8_t CLOCK_OPTION_TIMEZONE = 0;
+const uint8_t CLOCK_OPTION_DST = 1;
+const uint8_t CLOCK_OPTION_FACE_EFFECTS = 2;
+const uint8_t CLOCK_OPTION_FADE_EFFECTS = 3;
+const uint8_t CLOCK_OPTION_DAYTIME_BRIGHTNESS = 4;
+const uint8_t CLOCK_OPTION_NIGHT_BRIGHTNESS = 5;
+const uint8_t CLOCK_OPTION_AUTO_BRIGHTNESS = 6;
+const uint8_t CLOCK_OPTION_DISPLAY_MODE = 7;
+const uint8_t CLOCK_OPTION_PENDULUM_PERIOD = 8;
+const uint8_t CLOCK_OPTION_UTILITY_MODE = 9;
+
 
 /**
  * Class containing clock options, as well as handling saving/loading of options from EEPROM
@@ -72,15 +92,20 @@ public:
   void setFadeEffectsEnabled(bool enabled);
 
   /**
-   * Sets the brightness of the clock LEDs during the day (6 AM to 6 PM)
+   * Sets the brightness of the clock LEDs during the day (see SunSchedule)
    */
   void setDaytimeBrightness(uint8_t value);
 
   /**
-   * Sets the brightness of the clock LEDs during the night (6 PM to 6 AM)
+   * Sets the brightness of the clock LEDs during the night (see SunSchedule); 0 turns the display off at night
    */
   void setNightBrightness(uint8_t value);
 
+  /**
+   * Sets whether the brightness follows the ambient light sensor rather than the time of day
+   */
+  void setAutoBrightnessEnabled(bool enabled);
+
   /**
    * Sets the clock display mode (see CLOCK_DISPLAY_MODE_* for valid values)
    */
@@ -119,14 +144,19 @@ public:
   bool getFadeEffectsEnabled() const;
 
   /**
-   * Gets the brightness of the clock LEDs during the day (6 AM to 6 PM)
+   * Gets the brightness of the clock LEDs during the day (see SunSchedule)
    */
   uint8_t getDaytimeBrightness() const;
 
   /**
-   * Gets the brightness of the clock LEDs during the night (6 PM to 6 AM)
+   * Gets the brightness of the clock LEDs during the night (see SunSchedule)
    */
   uint8_t getNightBrightness() const;
+
+  /**
+   * Gets whether the brightness follows the ambient light sensor rather than the time of day
+   */
+  bool getAutoBrightnessEnabled() const;
   
   /**
    * Gets the current utility mode (see UTILITY_MODE_* for more info)
@@ -148,6 +178,16 @@ public:
    */
   uint8_t getPendulumPeriod() const;
 
+  /**
+   * Sets an option by ID (see CLOCK_OPTION_*); booleans are 0 or 1 and the timezone is cast from int8_t
+   */
+  void setOption(uint8_t option, uint8_t value);
+
+  /**
+   * Gets an option by ID (see CLOCK_OPTION_*); booleans are 0 or 1 and the timezone is cast to uint8_t
+   */
+  uint8_t getOption(uint8_t option) const;
+
   /**
    * Returns true if any options have changed since the last time this method was called
    */
@@ -167,6 +207,7 @@ private:
   bool fadeEffectsEnabled;
   uint8_t daytimeBrightness;
   uint8_t nightBrightness;
+  bool autoBrightnessEnabled;
   uint8_t displayMode;
   uint8_t pendulumPeriod;
 
@@ -0,0 +1,42 @@
+#include "Arduino.h"
+#include "ClockTime.h"
+
+#ifdef CLOCK_VIRTUAL_TIME
+
+static uint64_t virtualMicroseconds = 0;
+
+uint32_t clockMillis() {
+  return static_cast<uint32_t>(virtualMicroseconds / 1000);
+}
+
+uint32_t clockMicros() {
+  return static_cast<uint32_t>(virtualMicroseconds);
+}
+
+void clockDelay(uint32_t milliseconds) {
+  virtualMicroseconds += static_cast<uint64_t>(milliseconds) * 1000;
+}
+
+void advanceClockTime(uint32_t microseconds) {
+  virtualMicroseconds += microseconds;
+}
+
+uint64_t getClockTime() {
+  return virtualMicroseconds;
+}
+
+
+void VirtualRTC::begin(const DateTime &time) {
+  adjust(time);
+}
+
+void VirtualRTC::adjust(const DateTime &time) {
+  adjustedUnixTime = time.unixtime();
+  adjustedClockTime = virtualMicroseconds;
+}
+
+DateTime VirtualRTC::now() {
+  return DateTime(adjustedUnixTime + static_cast<uint32_t>((virtualMicroseconds - adjustedClockTime) / 1000000));
+}
+
+#endif
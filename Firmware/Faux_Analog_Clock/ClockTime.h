@@ -0,0 +1,80 @@
+#ifndef CLOCK_TIME_H
+#define CLOCK_TIME_H
+
+#include "Arduino.h"
+#include <RTClib.h>
+
+/*
+ * The time source for everything in the clock which measures elapsed time.
+ *
+ * On the clock, this is just millis()/micros()/delay().
+ * A host build can define CLOCK_VIRTUAL_TIME instead, in which case time only moves when advanceClockTime() is called
+ * (or when the clock itself waits, e.g. for a display frame), so a harness can run the clock as fast as it likes.
+ * The RTC is then replaced by VirtualRTC, which counts virtual time.
+ */
+
+#ifdef CLOCK_VIRTUAL_TIME
+
+#ifndef CLOCK_VIRTUAL_MIN_FRAME_MICROS
+/**
+ * The shortest virtual display frame, in microseconds (0 keeps the frame timing of the real display)
+ */
+#define CLOCK_VIRTUAL_MIN_FRAME_MICROS 0UL
+#endif
+
+/**
+ * Gets the virtual time in milliseconds (wraps like millis())
+ */
+uint32_t clockMillis();
+
+/**
+ * Gets the virtual time in microseconds (wraps like micros())
+ */
+uint32_t clockMicros();
+
+/**
+ * Waits the given number of milliseconds (advances the virtual time)
+ */
+void clockDelay(uint32_t milliseconds);
+
+/**
+ * Advances the virtual time by the given number of microseconds
+ */
+void advanceClockTime(uint32_t microseconds);
+
+/**
+ * Gets the total virtual time in microseconds (never wraps)
+ */
+uint64_t getClockTime();
+
+/**
+ * An RTC running on virtual time (used in place of the DS1307)
+ */
+class VirtualRTC {
+public:
+  void begin(const DateTime &time);
+  void adjust(const DateTime &time);
+  DateTime now();
+
+private:
+  uint32_t adjustedUnixTime;
+  uint64_t adjustedClockTime;
+};
+
+#else
+
+inline uint32_t clockMillis() {
+  return millis();
+}
+
+inline uint32_t clockMicros() {
+  return micros();
+}
+
+inline void clockDelay(uint32_t milliseconds) {
+  delay(milliseconds);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef CONSTEXPR_TABLE_H
+#define CONSTEXPR_TABLE_H
+
+#include "Arduino.h"
+
+/*
+ * Compile-time lookup table generation (C++11, so every constexpr function is a single return statement).
+ *
+ * A generator is a struct providing the table's value type, its size and a constexpr function computing each entry:
+ *
+ *   struct ExampleGenerator {
+ *     typedef uint8_t Type;
+ *     static const uint16_t SIZE = 16;
+ *     static constexpr Type value(uint16_t index) { return index * 2; }
+ *   };
+ *
+ * ConstexprTable<ExampleGenerator>::values is then a PROGMEM array of value(0)..value(SIZE - 1), filled in by the compiler.
+ */
+
+template<uint16_t... Indices>
+struct TableIndices {};
+
+/**
+ * Appends a second run of indices to a first, offsetting the second by the length of the first
+ */
+template<typename First, typename Second>
+struct ConcatTableIndices;
+
+template<uint16_t... First, uint16_t... Second>
+struct ConcatTableIndices<TableIndices<First...>, TableIndices<Second...> > {
+  typedef TableIndices<First..., (sizeof...(First) + Second)...> Type;
+};
+
+/**
+ * Builds the indices 0..Count - 1 by halving, so the template instantiation depth grows with log2(Count) rather than Count
+ */
+template<uint16_t Count>
+struct MakeTableIndices {
+  typedef typename ConcatTableIndices<typename MakeTableIndices<Count / 2>::Type, typename MakeTableIndices<Count - Count / 2>::Type>::Type Type;
+};
+
+template<>
+struct MakeTableIndices<0> {
+  typedef TableIndices<> Type;
+};
+
+template<>
+struct MakeTableIndices<1> {
+  typedef TableIndices<0> Type;
+};
+
+template<typename Generator, typename Indices = typename MakeTableIndices<Generator::SIZE>::Type>
+struct ConstexprTable;
+
+template<typename Generator, uint16_t... Indices>
+struct ConstexprTable<Generator, TableIndices<Indices...> > {
+  static_assert(Generator::SIZE > 0 && sizeof...(Indices) == Generator::SIZE, "A generated table needs between 1 and 65535 entries");
+
+  static const typename Generator::Type values[sizeof...(Indices)] PROGMEM;
+};
+
+template<typename Generator, uint16_t... Indices>
+const typename Generator::Type ConstexprTable<Generator, TableIndices<Indices...> >::values[sizeof...(Indices)] PROGMEM = {
+  Generator::value(Indices)...
+};
+
+
+/*
+ * constexpr math for table generators (never used at runtime)
+ */
+
+constexpr double CONSTEXPR_PI = 3.14159265358979;
+constexpr double CONSTEXPR_LN2 = 0.693147180559945;
+
+/**
+ * Rounds to the nearest integer
+ */
+constexpr int32_t constexprRound(double x) {
+  return x >= 0 ? static_cast<int32_t>(x + 0.5) : -static_cast<int32_t>(-x + 0.5);
+}
+
+constexpr double constexprSquare(double x) {
+  return x * x;
+}
+
+constexpr double constexprSinSeries(double xSquared, double term, uint8_t n) {
+  return n > 10 ? term : term + constexprSinSeries(xSquared, -term * xSquared / ((2 * n) * (2 * n + 1)), n + 1);
+}
+
+/**
+ * Sine (Taylor series, accurate for |x| <= pi)
+ */
+constexpr double constexprSin(double x) {
+  return constexprSinSeries(x * x, x, 1);
+}
+
+constexpr double constexprLogSeries(double ySquared, double term, uint8_t n) {
+  return n > 12 ? 0 : term / (2 * n + 1) + constexprLogSeries(ySquared, term * ySquared, n + 1);
+}
+
+/**
+ * Natural logarithm (x > 0), range-reduced into [0.5, 1] before using the atanh series
+ */
+constexpr double constexprLog(double x) {
+  return x < 0.5 ? constexprLog(x * 2) - CONSTEXPR_LN2
+    : x > 1 ? constexprLog(x / 2) + CONSTEXPR_LN2
+    : 2 * constexprLogSeries(constexprSquare((x - 1) / (x + 1)), (x - 1) / (x + 1), 0);
+}
+
+constexpr double constexprExpSeries(double x, double term, uint8_t n) {
+  return n > 10 ? term : term + constexprExpSeries(x, term * x / n, n + 1);
+}
+
+/**
+ * Exponential function, range-reduced by halving before using the Taylor series
+ */
+constexpr double constexprExp(double x) {
+  return (x < -0.5 || x > 0.5) ? constexprSquare(constexprExp(x / 2)) : constexprExpSeries(x, 1, 1);
+}
+
+/**
+ * x raised to the power y (x >= 0)
+ */
+constexpr double constexprPow(double x, double y) {
+  return x <= 0 ? 0 : constexprExp(y * constexprLog(x));
+}
+
+#endif
@@ -0,0 +1,272 @@
+#include "Arduino.h"
+#include <util/atomic.h>
+#include <util/twi.h>
+#include "DS1307.h"
+#include "ClockTime.h"
+#include "Trace.h"
+
+const uint8_t DS1307_ADDRESS = 0x68;
+
+// SDA and SCL are PC4 and PC5
+const uint8_t DS1307_SDA_MASK = 0b00010000;
+const uint8_t DS1307_SCL_MASK = 0b00100000;
+
+// Transaction states
+const uint8_t DS1307_STATE_IDLE = 0;
+const uint8_t DS1307_STATE_WRITING = 1;
+const uint8_t DS1307_STATE_READING = 2;
+
+// TWCR values (the interrupt stays enabled while a transaction is under way)
+const uint8_t DS1307_TWCR_NEXT = _BV(TWEN) | _BV(TWIE) | _BV(TWINT);
+const uint8_t DS1307_TWCR_START = DS1307_TWCR_NEXT | _BV(TWSTA);
+const uint8_t DS1307_TWCR_STOP = _BV(TWEN) | _BV(TWINT) | _BV(TWSTO);
+
+// The driver serviced by the TWI interrupt
+static DS1307 *activeRTC = NULL;
+
+#ifndef CLOCK_VIRTUAL_TIME
+ISR(TWI_vect) {
+  activeRTC->handleInterrupt();
+}
+#endif
+
+static inline uint8_t bcdToBinary(uint8_t value) {
+  return (value >> 4) * 10 + (value & 0x0f);
+}
+
+static inline uint8_t binaryToBCD(uint8_t value) {
+  return static_cast<uint8_t>(((value / 10) << 4) | (value % 10));
+}
+
+
+DS1307::DS1307() {
+  state = DS1307_STATE_IDLE;
+  readDiscarded = false;
+  readPublished = false;
+  errorCount = 0;
+  writeLength = 0;
+  writeIndex = 0;
+  readLength = 0;
+  readIndex = 0;
+  writePending = false;
+  transactionStartMillis = 0;
+  busRecoveryCount = 0;
+  publishedMillis = 0;
+}
+
+void DS1307::begin() {
+  activeRTC = this;
+
+  // Internal pull-ups (the board should have its own as well)
+  DDRC &= ~(DS1307_SDA_MASK | DS1307_SCL_MASK);
+  PORTC |= DS1307_SDA_MASK | DS1307_SCL_MASK;
+
+  TWSR = 0; // Prescaler of 1
+  TWBR = static_cast<uint8_t>((F_CPU / DS1307_TWI_FREQUENCY - 16) / 2);
+  TWCR = _BV(TWEN);
+}
+
+bool DS1307::read(DateTime &time, uint32_t &readMillis) {
+  update();
+
+  // Take the published registers (if any) before another read can overwrite them
+  bool published = false;
+  uint8_t registers[7];
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    published = readPublished;
+    if (published) {
+      memcpy(registers, publishedRegisters, sizeof(registers));
+      readMillis = publishedMillis;
+      readPublished = false;
+    }
+  }
+
+  if (isBusFree() && !writePending) {
+    TRACE(TRACE_EVENT_RTC_READ_BEGIN, 0);
+    writeBuffer[0] = 0; // Register address
+    startTransaction(1, sizeof(readBuffer));
+  }
+
+  if (published) {
+    time = decodeTime(registers);
+  }
+  return published;
+}
+
+bool DS1307::readBlocking(DateTime &time) {
+  uint32_t readMillis;
+  uint32_t startMillis = clockMillis();
+  while (clockMillis() - startMillis < DS1307_BLOCKING_TIMEOUT_MS) {
+    if (read(time, readMillis)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DS1307::adjust(const DateTime &time) {
+  uint8_t buffer[8] = {
+    0, // Register address
+    binaryToBCD(time.second()), // Also clears the clock halt bit
+    binaryToBCD(time.minute()),
+    binaryToBCD(time.hour()), // 24 hour mode
+    binaryToBCD(time.dayOfTheWeek() + 1),
+    binaryToBCD(time.day()),
+    binaryToBCD(time.month()),
+    binaryToBCD(static_cast<uint8_t>(time.year() - 2000))
+  };
+  memcpy(pendingWriteBuffer, buffer, sizeof(buffer));
+  writePending = true;
+
+  // Nothing read from before the write may be published after it
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    readDiscarded = state == DS1307_STATE_READING || (state == DS1307_STATE_WRITING && readLength > 0);
+    readPublished = false;
+  }
+  update();
+}
+
+uint16_t DS1307::getErrorCount() const {
+  return errorCount;
+}
+
+uint16_t DS1307::getBusRecoveryCount() const {
+  return busRecoveryCount;
+}
+
+void DS1307::update() {
+  if (state != DS1307_STATE_IDLE && clockMillis() - transactionStartMillis > DS1307_TIMEOUT_MS) {
+    // The transaction is stuck (e.g. a slave is holding the bus): abandon it
+    TWCR = 0;
+    state = DS1307_STATE_IDLE;
+    if (errorCount < 65535) {
+      ++errorCount;
+    }
+    recoverBus();
+    TWCR = _BV(TWEN);
+  }
+
+  if (writePending && isBusFree()) {
+    memcpy(writeBuffer, pendingWriteBuffer, sizeof(writeBuffer));
+    writePending = false;
+    startTransaction(sizeof(writeBuffer), 0);
+  }
+}
+
+bool DS1307::isBusFree() const {
+  return state == DS1307_STATE_IDLE && (TWCR & _BV(TWSTO)) == 0;
+}
+
+void DS1307::startTransaction(uint8_t writeLength, uint8_t readLength) {
+  this->writeLength = writeLength;
+  this->readLength = readLength;
+  writeIndex = 0;
+  readIndex = 0;
+  readDiscarded = false;
+  transactionStartMillis = clockMillis();
+  state = DS1307_STATE_WRITING;
+  TWCR = DS1307_TWCR_START;
+}
+
+void DS1307::endTransaction(bool success) {
+  TWCR = DS1307_TWCR_STOP;
+  state = DS1307_STATE_IDLE;
+  if (!success) {
+    if (errorCount < 65535) {
+      ++errorCount;
+    }
+  } else if (readLength > 0 && !readDiscarded) {
+    memcpy(publishedRegisters, readBuffer, sizeof(publishedRegisters));
+    publishedMillis = clockMillis();
+    readPublished = true;
+    TRACE(TRACE_EVENT_RTC_READ_END, bcdToBinary(readBuffer[0] & 0x7f));
+  }
+}
+
+void DS1307::handleInterrupt() {
+  switch (TW_STATUS) {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = (DS1307_ADDRESS << 1) | (state == DS1307_STATE_READING ? TW_READ : TW_WRITE);
+      TWCR = DS1307_TWCR_NEXT;
+      break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (writeIndex < writeLength) {
+        TWDR = writeBuffer[writeIndex++];
+        TWCR = DS1307_TWCR_NEXT;
+      } else if (readLength > 0) {
+        // Repeated start, then read
+        state = DS1307_STATE_READING;
+        TWCR = DS1307_TWCR_START;
+      } else {
+        endTransaction(true);
+      }
+      break;
+
+    case TW_MR_SLA_ACK:
+      // Acknowledge every byte but the last
+      TWCR = DS1307_TWCR_NEXT | (readLength > 1 ? _BV(TWEA) : 0);
+      break;
+
+    case TW_MR_DATA_ACK:
+      readBuffer[readIndex++] = TWDR;
+      TWCR = DS1307_TWCR_NEXT | (readIndex + 1 < readLength ? _BV(TWEA) : 0);
+      break;
+
+    case TW_MR_DATA_NACK:
+      readBuffer[readIndex++] = TWDR;
+      endTransaction(readIndex == readLength);
+      break;
+
+    case TW_MT_ARB_LOST:
+      // Only one master is on the bus, so this is noise; give up on the transaction
+      TWCR = _BV(TWEN);
+      state = DS1307_STATE_IDLE;
+      if (errorCount < 65535) {
+        ++errorCount;
+      }
+      break;
+
+    default:
+      // Address or data not acknowledged, or a bus error
+      endTransaction(false);
+      break;
+  }
+}
+
+void DS1307::recoverBus() {
+  // Drive the lines by hand (open drain: low, or released to the pull-ups)
+  DDRC &= ~(DS1307_SDA_MASK | DS1307_SCL_MASK);
+  PORTC &= ~(DS1307_SDA_MASK | DS1307_SCL_MASK);
+
+  // Clock out the rest of any byte a slave is sending (at most nine clocks), until it lets go of SDA
+  for (uint8_t i = 0; i < 9 && (PINC & DS1307_SDA_MASK) == 0; ++i) {
+    DDRC |= DS1307_SCL_MASK;
+    delayMicroseconds(5);
+    DDRC &= ~DS1307_SCL_MASK;
+    delayMicroseconds(5);
+  }
+
+  // Stop: SDA rises while SCL is high
+  DDRC |= DS1307_SDA_MASK;
+  delayMicroseconds(5);
+  DDRC &= ~DS1307_SDA_MASK;
+  delayMicroseconds(5);
+
+  PORTC |= DS1307_SDA_MASK | DS1307_SCL_MASK;
+  if (busRecoveryCount < 65535) {
+    ++busRecoveryCount;
+  }
+}
+
+DateTime DS1307::decodeTime(const uint8_t *registers) {
+  return DateTime(
+    2000 + bcdToBinary(registers[6]),
+    bcdToBinary(registers[5]),
+    bcdToBinary(registers[4]),
+    bcdToBinary(registers[2] & 0x3f),
+    bcdToBinary(registers[1]),
+    bcdToBinary(registers[0] & 0x7f));
+}
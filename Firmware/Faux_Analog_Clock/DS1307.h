@@ -0,0 +1,132 @@
+#ifndef DS1307_H
+#define DS1307_H
+
+#include "Arduino.h"
+#include <RTClib.h>
+
+/**
+ * The TWI bit rate, in Hz
+ */
+const uint32_t DS1307_TWI_FREQUENCY = 100000;
+
+/**
+ * The number of milliseconds after which an unfinished transaction is abandoned and the bus recovered
+ * (a read takes about a millisecond at 100 kHz)
+ */
+const uint8_t DS1307_TIMEOUT_MS = 10;
+
+/**
+ * The number of milliseconds begin() and readBlocking() wait for a transaction before giving up
+ */
+const uint8_t DS1307_BLOCKING_TIMEOUT_MS = 50;
+
+/**
+ * Interrupt-driven driver for the DS1307 RTC, which never waits on the bus.
+ * read() starts reading the time registers and returns at once; the transaction runs in the TWI interrupt, which
+ * publishes the registers when it finishes, and the next read() decodes them.
+ * A transaction which doesn't finish within DS1307_TIMEOUT_MS is abandoned, and the bus is recovered (by clocking out
+ * whatever a slave was sending, then sending a stop), so a stuck bus can't hang the clock.
+ * Only one instance may exist (it owns the TWI hardware and its interrupt).
+ */
+class DS1307 {
+public:
+  DS1307();
+
+  /**
+   * Starts the TWI hardware (at DS1307_TWI_FREQUENCY, with the internal pull-ups on)
+   */
+  void begin();
+
+  /**
+   * Gets the time read by the last transaction if it's new, and starts the next read if the bus is free
+   *
+   * @param time Set to the new time
+   * @param readMillis Set to the clockMillis() at which the time was read
+   * @return True if a new time was read
+   */
+  bool read(DateTime &time, uint32_t &readMillis);
+
+  /**
+   * Reads the time, waiting (for up to DS1307_BLOCKING_TIMEOUT_MS) for the transaction to finish (for use at startup)
+   *
+   * @param time Set to the time
+   * @return True if the time was read
+   */
+  bool readBlocking(DateTime &time);
+
+  /**
+   * Sets the time (the write is queued, and takes priority over reads; a read already under way is discarded)
+   *
+   * @param time The time to set
+   */
+  void adjust(const DateTime &time);
+
+  /**
+   * Gets the number of transactions which failed (a missing acknowledgement, a bus error or a timeout)
+   */
+  uint16_t getErrorCount() const;
+
+  /**
+   * Gets the number of times the bus was recovered after a timeout
+   */
+  uint16_t getBusRecoveryCount() const;
+
+  /**
+   * Handles the TWI interrupt (for the ISR only)
+   */
+  void handleInterrupt();
+
+private:
+  // Transaction buffers (a write sends the register address and then the time registers)
+  uint8_t writeBuffer[8];
+  uint8_t readBuffer[7];
+  uint8_t pendingWriteBuffer[8];
+
+  volatile uint8_t state;
+  volatile bool readDiscarded;
+  volatile bool readPublished;
+  volatile uint16_t errorCount;
+  uint8_t writeLength;
+  uint8_t writeIndex;
+  uint8_t readLength;
+  uint8_t readIndex;
+  bool writePending;
+  uint32_t transactionStartMillis;
+  uint16_t busRecoveryCount;
+
+  // The registers published by the last read
+  uint8_t publishedRegisters[7];
+  uint32_t publishedMillis;
+
+  /**
+   * Abandons the current transaction if it has timed out, and starts a pending write if the bus is free
+   */
+  void update();
+
+  /**
+   * Returns true if a transaction can be started (none is under way, and the last one's stop has been sent)
+   */
+  bool isBusFree() const;
+
+  /**
+   * Starts a transaction: writes writeLength bytes from writeBuffer, then reads readLength bytes into readBuffer
+   */
+  void startTransaction(uint8_t writeLength, uint8_t readLength);
+
+  /**
+   * Ends the current transaction with a stop, publishing the registers read if it was successful
+   */
+  void endTransaction(bool success);
+
+  /**
+   * Releases a bus held by a slave: clocks SCL until SDA is released, then sends a stop
+   */
+  void recoverBus();
+
+  /**
+   * Decodes published time registers
+   */
+  static DateTime decodeTime(const uint8_t *registers);
+};
+
+#endif
@@ -4,8 +4,18 @@
 #include "ClockOptions.h"
 #include "SevenSegment.h"
 #include "ClockMenu.h"
+#include "ClockCompositor.h"
 #include "ClockFrameBuffers.h"
 #include "ClockDisplayMode.h"
+#include "SunSchedule.h"
+#include "AmbientLight.h"
+#include "Pendulum.h"
+#include "TaskScheduler.h"
+#include "Trace.h"
+#include "ClockTime.h"
+#include "MemoryMonitor.h"
+#include "Watchdog.h"
+#include "ClockAnimation.h"
 
 /**
  * Faux Analog Clock
@@ -18,7 +28,7 @@
  *  Adafruit BusIO 1.14.1
  *  Adafruit GPS 1.7.2
  * 
- * Pinout:
+ * Pinout (the Charlieplex lines are described in ClockBoard.h):
  *  RTC SDA            = PC4
  *  RTC SCL            = PC5
  *  GPS TX             = PC2
@@ -28,6 +38,7 @@
  *  Charlieplex 12..13 = PORTC 0..1
  *  Select Button      = PB4
  *  Enter Button       = PB5
+ *  Light Sensor       = ADC6 (optional photoresistor divider)
  */
 
 /*
@@ -38,6 +49,10 @@ const uint32_t CLOCK_ANIM_MINUTES_FADE_TIME = 2000;
 const uint32_t CLOCK_ANIM_HOURS_FADE_TIME = 4000;
 const uint32_t CLOCK_ANIM_PENDULUM_FADE_TIME = 2000;
 const uint32_t CLOCK_ANIM_RING_FADE_TIME = 1500000;
+const uint16_t CLOCK_ANIM_LED_TEST_STEP_TIME = 250;
+
+// Uncomment this to compute the fades from their start time whenever a frame is composited, instead of stepping them on every fade task run (costs a byte of RAM per faded LED, see the SRAM budget in README.md)
+//#define USE_TIMED_FADES 1
 
 /*
  * Menu configuration
@@ -47,32 +62,145 @@ const uint8_t MENU_ENTER_BUTTON_MASK = 0b00100000;
 const uint32_t MENU_TIMEOUT_MS = 10000;
 const uint32_t MENU_BACK_BUTTON_LONG_PRESS_MS = 1000;
 
+/*
+ * Trace readout configuration (see Trace.h)
+ */
+const uint32_t TRACE_READOUT_BYTE_MS = 1000;
+
 /*
  * Timekeeper configuration
  */
 const uint32_t TIMEKEEPER_GPS_TIME_SET_INTERVAL_SECONDS = 86400;
 
+/*
+ * Task scheduling (see the run*Task() functions below), in priority order, with periods and deadlines in milliseconds
+ */
+void runTimekeeperTask();
+void runMenuTask();
+void runBrightnessTask();
+void runFadeTask();
+void runFaceTask();
+void runAnimationTask();
+void runMemoryTask();
+void runDisplayTask();
+
+const PROGMEM ScheduledTask CLOCK_TASKS[] = {
+  { runTimekeeperTask, 10,  50 },  // GPS serial parsing must keep up with its receive buffer; the RTC is only read around second boundaries
+  { runMenuTask,       10,  50 },  // Button edges are queued by the pin change interrupt
+  { runBrightnessTask, 100, 200 },
+  { runFadeTask,       4,   40 },
+  { runFaceTask,       16,  40 },  // Pendulum animation rate
+  { runAnimationTask,  16,  40 },
+  { runMemoryTask,     1000, 100 }, // Stack high-water scan
+  { runDisplayTask,    0,   40 }   // Every pass; deadline from its own start (a frame takes up to ~21 ms, most of which is slept through)
+};
+
+/*
+ * Ambient light sensor configuration
+ */
+const uint8_t AMBIENT_LIGHT_ADC_CHANNEL = 6;
+const uint16_t AMBIENT_LIGHT_DARK_LEVEL = 64;
+const uint16_t AMBIENT_LIGHT_BRIGHT_LEVEL = 768;
+
+/*
+ * Animation scripts (see ClockAnimation.h) and the targets they draw into (see ANIMATION_TARGETS below)
+ */
+const uint8_t ANIMATION_TARGET_DISPLAY = 0;       // Every LED (base layer)
+const uint8_t ANIMATION_TARGET_DISPLAY_DOT = 1;   // A single LED, by index (base layer)
+const uint8_t ANIMATION_TARGET_OVERLAY_INNER = 2; // Inner ring (overlay layer)
+const uint8_t ANIMATION_TARGET_OVERLAY_OUTER = 3; // Outer ring (overlay layer)
+
+// Startup: fade every LED in and out
+const PROGMEM AnimationKeyframe STARTUP_KEYFRAMES[] = {
+  { ANIMATION_TARGET_DISPLAY, 255, 1300, ANIMATION_EASING_LINEAR },
+  { ANIMATION_TARGET_DISPLAY, 255, 1200, ANIMATION_EASING_LINEAR },
+  { ANIMATION_TARGET_DISPLAY, 0,   1300, ANIMATION_EASING_LINEAR }
+};
+
+// Time set: the rings fade back and forth in opposite directions (played until the time is set)
+const PROGMEM AnimationKeyframe TIME_SET_KEYFRAMES[] = {
+  { ANIMATION_TARGET_OVERLAY_INNER, 255, 0,    ANIMATION_EASING_LINEAR },
+  { ANIMATION_TARGET_OVERLAY_INNER, 5,   2000, ANIMATION_EASING_LINEAR },
+  { ANIMATION_TARGET_OVERLAY_INNER, 255, 2000, ANIMATION_EASING_LINEAR },
+  { ANIMATION_TARGET_OVERLAY_OUTER, 250, 2000, ANIMATION_EASING_LINEAR },
+  { ANIMATION_TARGET_OVERLAY_OUTER, 0,   2000, ANIMATION_EASING_LINEAR }
+};
+
+// LED test 1: every LED at full intensity (played until a button is pressed)
+const PROGMEM AnimationKeyframe LED_TEST_1_KEYFRAMES[] = {
+  { ANIMATION_TARGET_DISPLAY, 255, 0, ANIMATION_EASING_LINEAR }
+};
+
+// LED test 2: each LED at full intensity in sequence, for CLOCK_ANIM_LED_TEST_STEP_TIME each (played until a button is pressed)
+const PROGMEM AnimationKeyframe LED_TEST_2_KEYFRAMES[] = {
+  { ANIMATION_TARGET_DISPLAY_DOT, CLOCK_DISPLAY_LED_COUNT, CLOCK_DISPLAY_LED_COUNT * CLOCK_ANIM_LED_TEST_STEP_TIME, ANIMATION_EASING_LINEAR }
+};
+
+const PROGMEM AnimationScript STARTUP_ANIMATION = { STARTUP_KEYFRAMES, sizeof(STARTUP_KEYFRAMES) / sizeof(STARTUP_KEYFRAMES[0]), false };
+const PROGMEM AnimationScript TIME_SET_ANIMATION = { TIME_SET_KEYFRAMES, sizeof(TIME_SET_KEYFRAMES) / sizeof(TIME_SET_KEYFRAMES[0]), true };
+const PROGMEM AnimationScript LED_TEST_1_ANIMATION = { LED_TEST_1_KEYFRAMES, sizeof(LED_TEST_1_KEYFRAMES) / sizeof(LED_TEST_1_KEYFRAMES[0]), true };
+const PROGMEM AnimationScript LED_TEST_2_ANIMATION = { LED_TEST_2_KEYFRAMES, sizeof(LED_TEST_2_KEYFRAMES) / sizeof(LED_TEST_2_KEYFRAMES[0]), true };
+
 
 /*
  * Various classes which are integral to clock operation
  */
 ClockDisplay clockDisplay;
-ClockFrameBuffers clockFrameBuffers(clockDisplay);
+ClockCompositor clockCompositor(clockDisplay);
+ClockFrameBuffers clockFrameBuffers(clockCompositor);
+SevenSegmentText indicatorText(clockFrameBuffers.getDisplayLeftBuffer(), clockFrameBuffers.getDisplayRightBuffer());
+SevenSegmentText menuText(clockFrameBuffers.getMenuLeftBuffer(), clockFrameBuffers.getMenuRightBuffer());
 Timekeeper timekeeper(A2, A3, TIMEKEEPER_GPS_TIME_SET_INTERVAL_SECONDS);
+SunSchedule sunSchedule;
+AmbientLight ambientLight(AMBIENT_LIGHT_ADC_CHANNEL, AMBIENT_LIGHT_DARK_LEVEL, AMBIENT_LIGHT_BRIGHT_LEVEL);
 
 ClockOptions options;
 ClockMenu menu(options, MENU_SELECT_BUTTON_MASK, MENU_ENTER_BUTTON_MASK, MENU_TIMEOUT_MS, MENU_BACK_BUTTON_LONG_PRESS_MS);
 
 ClockDisplayMode *displayMode = new AnalogClockDisplayMode();
 
+TaskScheduler taskScheduler(CLOCK_TASKS, sizeof(CLOCK_TASKS) / sizeof(CLOCK_TASKS[0]));
+
+const AnimationTarget ANIMATION_TARGETS[] = {
+  { clockFrameBuffers.getBaseBuffer(), ANIMATION_DRAW_FILL },
+  { clockFrameBuffers.getBaseBuffer(), ANIMATION_DRAW_DOT },
+  { clockFrameBuffers.getOverlayInnerRingBuffer(), ANIMATION_DRAW_FILL },
+  { clockFrameBuffers.getOverlayOuterRingBuffer(), ANIMATION_DRAW_FILL }
+};
+ClockAnimation displayAnimation(ANIMATION_TARGETS, sizeof(ANIMATION_TARGETS) / sizeof(ANIMATION_TARGETS[0])); // Startup and LED tests (takes over the display)
+ClockAnimation overlayAnimation(ANIMATION_TARGETS, sizeof(ANIMATION_TARGETS) / sizeof(ANIMATION_TARGETS[0])); // Time set
+
+
+// Brightness of the clock, as of the last brightness task
+uint8_t currentBrightness = 0;
+
+// Pendulum phase advance per millisecond (see getPendulumPhaseStep())
+uint16_t pendulumPhaseStep = getPendulumPhaseStep(1);
+
+// Start of the trace log readout
+uint32_t traceReadoutStartMillis = 0;
 
-// Clock set animation vars
-uint8_t clockSetAnimationValue = 0;
-int8_t clockSetAnimationDirection = 1;
+// LED calibration state: whether it has taken over the display, the LED being calibrated and the buttons as of its last update
+bool ledCalibrationActive = false;
+ClockDisplayIndex ledCalibrationIndex = 0;
+bool ledCalibrationSelectPressed = false;
+bool ledCalibrationEnterPressed = false;
+
+// Memory readout text, updated by the memory task ("Fr <minimum free> St <stack> HP <heap>", in bytes)
+char memoryReadoutText[28] = "";
+
+// Stall report text, refreshed when the stall report utility is selected ("St <count> <phase> <ms> rS <count> <phase> <ms>")
+char stallReportText[32] = "";
 
 
 // Main initialization routine
 void setup() {
+  // Start tracing (a trace from before the reset is kept)
+  traceBegin();
+
+  // Start the watchdog (a stall record from before the reset is kept)
+  watchdogBegin();
+
   // Start the clock display
   clockDisplay.begin();
 
@@ -89,10 +217,15 @@ void setup() {
     executeUtilityMode();
   }
 
-  // Do LED fade test
-  runLEDFadeTest();
+  // Fade the LEDs in and out (unless an LED test is running); this plays alongside the rest of the startup
+  if (!displayAnimation.isPlaying()) {
+    startDisplayAnimation(&STARTUP_ANIMATION);
+  }
 
   // Initialize timing buffers
+#ifdef USE_TIMED_FADES
+  clockFrameBuffers.enableTimedFade();
+#endif
   clockFrameBuffers.getSecondBuffer()->initializeFade(CLOCK_ANIM_SECONDS_FADE_TIME, 0);
   clockFrameBuffers.getMinuteBuffer()->initializeFade(CLOCK_ANIM_MINUTES_FADE_TIME, 0);
   clockFrameBuffers.getHourBuffer()->initializeFade(CLOCK_ANIM_HOURS_FADE_TIME, 0);
@@ -104,79 +237,337 @@ void setup() {
   clockFrameBuffers.getFaceOuterRingBuffer()->initializeFade(CLOCK_ANIM_RING_FADE_TIME, options.getDaytimeBrightness());
   clockFrameBuffers.getFaceOuterRingBuffer()->setAllValues(options.getDaytimeBrightness());
 
-  // Start the timekeeper
-  timekeeper.begin();
+  // Start the timekeeper (after a stall, carry on with the time from before the reset rather than waiting for the GPS)
+  timekeeper.begin(watchdogWasStallReset());
   timekeeper.setTimeZone(options.getTimezone(), options.getDST());
+  sunSchedule.setTimeZone(options.getTimezone(), options.getDST());
+  if (timekeeper.hasLocation()) {
+    sunSchedule.setLocation(timekeeper.getLatitude(), timekeeper.getLongitude());
+  }
+
+  // Start running tasks
+  taskScheduler.begin();
 }
 
 // Main loop
 void loop() {
-  bool wasTimeSetPendingLastIteration = timekeeper.isTimeSetPending();
+  taskScheduler.runDueTasks();
+}
+
+/**
+ * Timekeeper task: reads the GPS while the time is being set, tracks the RTC and handles the time set aftermath
+ */
+void runTimekeeperTask() {
+  bool wasTimeSetPending = timekeeper.isTimeSetPending();
   timekeeper.update();
 
   if (timekeeper.isTimeValid()) {
-    // Update time
     const DateTime &now = timekeeper.getTime();
-    bool isNight = now.hour() < 6 || now.hour() > 18;
-    
-    // Update menu and options
-    menu.update();
-    uint8_t brightness = isNight ? options.getPremultipliedNightBrightness() : options.getDaytimeBrightness();
+    sunSchedule.update(now);
+
+    if (wasTimeSetPending && !timekeeper.isTimeSetPending()) {
+      // If we previously had no time set (i.e. were playing the time set animation), snap the clock rings to whatever time they should be set for
+      overlayAnimation.stop();
+      clockCompositor.setLayerEnabled(CLOCK_LAYER_OVERLAY, false);
+      if (timekeeper.hasLocation()) {
+        sunSchedule.setLocation(timekeeper.getLatitude(), timekeeper.getLongitude());
+        sunSchedule.update(now);
+      }
+      updateBrightness();
+      updateClockFaceEffectMode(currentBrightness);
+    }
+  }
+}
+
+/**
+ * Menu task: polls the buttons and applies any changed options
+ */
+void runMenuTask() {
+  // The LED tests can be ended before the time is valid
+  if (timekeeper.isTimeValid() || options.getCurrentUtilityMode() != UTILITY_MODE_NONE) {
+    if (ledCalibrationActive) {
+      // The calibration uses the buttons itself
+      updateLedCalibration();
+    } else {
+      menu.update();
+    }
     if (options.getOptionsChanged()) {
-      updateOptions(brightness);
+      updateBrightness();
+      updateOptions(currentBrightness);
+    }
+  }
+}
+
+/**
+ * Brightness task: follows the ambient light sensor or the sunrise/sunset schedule
+ */
+void runBrightnessTask() {
+  if (timekeeper.isTimeValid()) {
+    if (options.getAutoBrightnessEnabled()) {
+      ambientLight.update();
     }
-    
-    // Update fade
+    updateBrightness();
+    updateClockRingFadeTargets(currentBrightness);
+  }
+}
+
+/**
+ * Fade task: advances the LED fades (timed fades are only evaluated when a frame is composited, see runDisplayTask())
+ */
+void runFadeTask() {
+#ifndef USE_TIMED_FADES
+  updateFades();
+#endif
+}
+
+/**
+ * Face task: draws the display mode, pendulum, AM/PM indicator, menu text and time set animation
+ */
+void runFaceTask() {
+  // Nothing is drawn while an animation or the LED calibration has taken over the display
+  if (isDisplayTakenOver()) {
+    return;
+  }
+
+  if (timekeeper.isTimeValid()) {
+    const DateTime &now = timekeeper.getTime();
+
+    // Compute pendulum position
+    uint16_t minuteMilliseconds = static_cast<uint16_t>(now.second()) * 1000 + timekeeper.getMilliseconds();
+    uint16_t pendulumPosition = getPendulumPosition(getPendulumPhase(minuteMilliseconds, pendulumPhaseStep));
+
+    // Update time display
+    displayMode->update(clockFrameBuffers, now, pendulumPosition, currentBrightness);
+
+    // AM/PM indicator
+    if (now.isPM()) {
+      indicatorText.setText(' ', 'P', currentBrightness);
+    } else {
+      indicatorText.setText('A', ' ', currentBrightness);
+    }
+
+    // Display menu? (the menu layer covers the AM/PM indicator)
+    switch (options.getCurrentUtilityMode()) {
+      case UTILITY_MODE_IDLE_METER:
+        // Show the CPU idle percentage (until a button is pressed)
+        clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, true);
+        writeMenuNumber(clockDisplay.getIdlePercent());
+        break;
+      case UTILITY_MODE_OVERRUN_METER:
+        // Show the number of task deadline overruns (until a button is pressed)
+        clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, true);
+        writeMenuNumber(taskScheduler.getTotalOverrunCount());
+        break;
+      case UTILITY_MODE_TRACE_READOUT:
+        // Show the trace log (until a button is pressed)
+        clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, true);
+        writeTraceReadout();
+        break;
+      case UTILITY_MODE_MEMORY_METER:
+        // Scroll the SRAM usage (until a button is pressed)
+        clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, true);
+        menuText.setScrollingRAMText(memoryReadoutText, currentBrightness);
+        break;
+      case UTILITY_MODE_STALL_REPORT:
+        // Scroll the watchdog stall report (until a button is pressed)
+        clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, true);
+        menuText.setScrollingRAMText(stallReportText, currentBrightness);
+        break;
+      default:
+        clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, menu.isOpen());
+        if (menu.isOpen()) {
+          // Main menu options scroll their full names; sub-menu items show their codes
+          const char *menuName = menu.getMenuName();
+          if (menuName != NULL) {
+            menuText.setScrollingText(menuName, currentBrightness);
+          } else {
+            const char *menuItemText = menu.getMenuText();
+            menuText.setText(menuItemText[0], menuItemText[1], currentBrightness);
+          }
+        } else {
+          // Restarts the menu names when the menu is opened again
+          menuText.setText(' ', ' ', currentBrightness);
+        }
+        break;
+    }
+  }
+
+  // Animate the clock face to show that the time is being set (drawn on the overlay layer, above the face effects)
+  if (!timekeeper.isTimeValid() || timekeeper.isTimeSetPending()) {
+    clockCompositor.setLayerEnabled(CLOCK_LAYER_OVERLAY, true);
+    overlayAnimation.play(&TIME_SET_ANIMATION);
+  }
+}
+
+/**
+ * Animation task: draws the playing animations (they run at the same speed however often this runs)
+ */
+void runAnimationTask() {
+  if (displayAnimation.isPlaying() && !displayAnimation.update()) {
+    // The startup animation has finished (the LED tests play until they're ended)
+    endDisplayAnimation();
+  }
+  overlayAnimation.update();
+}
+
+/**
+ * Memory task: measures the heap and the stack high-water mark and refreshes the memory readout text
+ */
+void runMemoryTask() {
+  memoryMonitorUpdate();
+
+  char *text = memoryReadoutText;
+  text = appendText(text, "Fr ");
+  text = appendDecimal(text, memoryStats.minimumFreeBytes);
+  text = appendText(text, " St ");
+  text = appendDecimal(text, memoryStats.stackBytes);
+  text = appendText(text, " HP ");
+  text = appendDecimal(text, memoryStats.heapBytes);
+  *text = 0;
+}
+
+/**
+ * Display task: composites the layers and scans one frame (the CPU sleeps through the off time of each frame)
+ */
+void runDisplayTask() {
+#ifdef USE_TIMED_FADES
+  updateFades();
+#endif
+  clockCompositor.composite();
+  clockDisplay.display();
+}
+
+/**
+ * Brings the LED fades up to date, or ends them if fade effects are disabled
+ */
+void updateFades() {
+  // The hands are left alone while an animation or the LED calibration has taken over the display
+  if (timekeeper.isTimeValid() && !isDisplayTakenOver()) {
     if (options.getFadeEffectsEnabled()) {
       clockFrameBuffers.updateFade();
     } else {
       clockFrameBuffers.accelerateFadeToEnd();
     }
+  }
+}
 
-    // Compute pendulum index
-    uint16_t milliseconds = timekeeper.getMilliseconds();
-    uint16_t pendulumOffset = ((now.second() % options.getPendulumPeriod()) * static_cast<uint16_t>(1000)) / options.getPendulumPeriod();
-    uint16_t pendulumIndex = pendulumOffset + milliseconds / options.getPendulumPeriod();
+/**
+ * Updates the current brightness from the ambient light sensor or the sunrise/sunset schedule
+ */
+void updateBrightness() {
+  if (options.getAutoBrightnessEnabled()) {
+    currentBrightness = ambientLight.getBrightness(options.getPremultipliedNightBrightness(), options.getDaytimeBrightness());
+  } else {
+    currentBrightness = sunSchedule.isNight() ? options.getPremultipliedNightBrightness() : options.getDaytimeBrightness();
+  }
 
-    // Update time display
-    displayMode->update(clockFrameBuffers, now, pendulumIndex, brightness);
+  // Wake the display while the menu is open (with the night brightness turned off, it's dark at night)
+  if (currentBrightness == 0 && (menu.isOpen() || options.getCurrentUtilityMode() != UTILITY_MODE_NONE)) {
+    currentBrightness = options.getDaytimeBrightness();
+  }
+}
 
-    // Update clock ring animation fade targets
-    updateClockRingFadeTargets(now.hour(), brightness);
+/**
+ * Writes the trace log readout to the menu 7-segment displays: "--", then each byte of the log in hex (one every TRACE_READOUT_BYTE_MS), repeating
+ */
+void writeTraceReadout() {
+  uint16_t logSize = traceGetLogSize();
+  uint16_t position = static_cast<uint16_t>(((clockMillis() - traceReadoutStartMillis) / TRACE_READOUT_BYTE_MS) % (logSize + 1));
+  if (position == 0) {
+    menuText.setText('-', '-', currentBrightness);
+  } else {
+    uint8_t value = traceGetLogByte(static_cast<uint8_t>(position - 1));
+    menuText.setText(getHexDigit(value >> 4), getHexDigit(value & 0x0f), currentBrightness);
+  }
+}
 
-    // Display menu?
-    if (menu.isOpen()) {
-      const char *menuText = menu.getMenuText();
-      writeSevenSegmentDisplay(clockFrameBuffers.getDisplayLeftBuffer(), menuText[0], brightness);
-      writeSevenSegmentDisplay(clockFrameBuffers.getDisplayRightBuffer(), menuText[1], brightness);
-    } else {
-      // AM/PM indicator
-      if (now.isPM()) {
-        writeSevenSegmentDisplay(clockFrameBuffers.getDisplayLeftBuffer(), ' ', brightness);
-        writeSevenSegmentDisplay(clockFrameBuffers.getDisplayRightBuffer(), 'P', brightness);
-      } else {
-        writeSevenSegmentDisplay(clockFrameBuffers.getDisplayLeftBuffer(), 'A', brightness);
-        writeSevenSegmentDisplay(clockFrameBuffers.getDisplayRightBuffer(), ' ', brightness);
-      }
-    }
+/**
+ * Gets the hexadecimal digit for the given value (0..15)
+ */
+inline char getHexDigit(uint8_t value) {
+  return value < 10 ? '0' + value : 'A' + (value - 10);
+}
 
-    // Update the time set animation and handle its aftermath
-    if (timekeeper.isTimeSetPending()) {
-      // If we're actively setting the time, play the time set animation
-      updateTimeSetAnimation();
-    } else if (wasTimeSetPendingLastIteration) {
-      // If we previously had no time set (i.e. were playing the time set animation), snap the clock rings to whatever time they should be set for
-      clockSetAnimationValue = 0;
-      clockSetAnimationDirection = 1;
-      updateClockFaceEffectMode(brightness);
-    }
+/**
+ * Refreshes the stall report text from the watchdog log ("--" if the clock has never stalled)
+ */
+void updateStallReport() {
+  char *text = stallReportText;
+  if (watchdogLog.stallCount == 0 && watchdogLog.resetCount == 0) {
+    text = appendText(text, "--");
   } else {
-    // Animate the clock face to show that the time is being set
-    updateTimeSetAnimation();
+    text = appendText(text, "St ");
+    text = appendDecimal(text, watchdogLog.stallCount);
+    if (watchdogLog.stallCount > 0) {
+      *text++ = ' ';
+      text = appendWatchdogPhase(text, watchdogLog.longestStallPhase);
+      *text++ = ' ';
+      text = appendDecimal(text, watchdogLog.longestStallMillis);
+    }
+    text = appendText(text, " rS ");
+    text = appendDecimal(text, watchdogLog.resetCount);
+    if (watchdogLog.resetCount > 0) {
+      *text++ = ' ';
+      text = appendWatchdogPhase(text, watchdogLog.resetPhase);
+      *text++ = ' ';
+      text = appendDecimal(text, watchdogLog.resetStallMillis);
+    }
   }
+  *text = 0;
+}
 
-  // Display the clock LEDs
-  clockDisplay.display();
+/**
+ * Writes the short name of a watchdog phase to the given position in a buffer, returning the position after it ("t<N>" for task N)
+ */
+char *appendWatchdogPhase(char *position, uint8_t phase) {
+  switch (phase) {
+    case WATCHDOG_PHASE_SETUP:
+      return appendText(position, "SU");
+    case WATCHDOG_PHASE_SCHEDULER:
+      return appendText(position, "Sc");
+    case WATCHDOG_PHASE_GPS_RESET:
+      return appendText(position, "GP");
+    default:
+      if (phase >= WATCHDOG_PHASE_FIRST_TASK) {
+        *position++ = 't';
+        return appendDecimal(position, phase - WATCHDOG_PHASE_FIRST_TASK);
+      }
+      return appendText(position, "--");
+  }
+}
+
+/**
+ * Copies text to the given position in a buffer, returning the position after it (the text isn't terminated)
+ */
+char *appendText(char *position, const char *text) {
+  while (*text != 0) {
+    *position++ = *text++;
+  }
+  return position;
+}
+
+/**
+ * Writes a number in decimal to the given position in a buffer, returning the position after it (the text isn't terminated)
+ */
+char *appendDecimal(char *position, uint16_t value) {
+  char digits[5];
+  uint8_t count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+  while (count > 0) {
+    *position++ = digits[--count];
+  }
+  return position;
+}
+
+/**
+ * Writes a number (0..99, larger numbers are shown as 99) to the menu 7-segment displays
+ */
+void writeMenuNumber(uint16_t value) {
+  uint8_t number = static_cast<uint8_t>(min(value, 99));
+  menuText.setText('0' + number / 10, '0' + number % 10, currentBrightness);
 }
 
 /**
@@ -185,8 +576,21 @@ void loop() {
  * @param brightness The current brightness of the clock
  */
 void updateOptions(uint8_t brightness) {
+  TRACE(TRACE_EVENT_OPTIONS_UPDATE_BEGIN, 0);
+
   // Set timezone
   timekeeper.setTimeZone(options.getTimezone(), options.getDST());
+  sunSchedule.setTimeZone(options.getTimezone(), options.getDST());
+
+  // Update pendulum period
+  pendulumPhaseStep = getPendulumPhaseStep(options.getPendulumPeriod());
+
+  // Start/stop the ambient light sensor
+  if (options.getAutoBrightnessEnabled()) {
+    ambientLight.begin();
+  } else {
+    ambientLight.end();
+  }
 
   // Update clock face effect mode
   updateClockFaceEffectMode(brightness);
@@ -215,22 +619,47 @@ void updateOptions(uint8_t brightness) {
 
   // Handle utility modes
   executeUtilityMode();
+
+  TRACE(TRACE_EVENT_OPTIONS_UPDATE_END, 0);
 }
 
 /**
  * Handle the currently selected utility mode (if any)
  */
 void executeUtilityMode() {
-  switch (options.getCurrentUtilityMode()) {
+  // Hold the trace log still while it's being read out
+  bool traceReadout = options.getCurrentUtilityMode() == UTILITY_MODE_TRACE_READOUT;
+  traceSetFrozen(traceReadout);
+  if (traceReadout) {
+    traceReadoutStartMillis = clockMillis();
+  }
+
+  // Leaving an LED test hands the display back
+  uint8_t utilityMode = options.getCurrentUtilityMode();
+  if ((displayAnimation.isPlaying(&LED_TEST_1_ANIMATION) && utilityMode != UTILITY_MODE_LED_TEST_1) ||
+      (displayAnimation.isPlaying(&LED_TEST_2_ANIMATION) && utilityMode != UTILITY_MODE_LED_TEST_2)) {
+    endDisplayAnimation();
+  }
+  if (ledCalibrationActive && utilityMode != UTILITY_MODE_LED_CALIBRATION) {
+    endLedCalibration();
+  }
+
+  switch (utilityMode) {
+    case UTILITY_MODE_STALL_REPORT:
+      updateStallReport();
+      break;
     case UTILITY_MODE_RESET_TIME:
       timekeeper.resetTime();
       options.setCurrentUtilityMode(UTILITY_MODE_NONE);
       break;
     case UTILITY_MODE_LED_TEST_1:
-      runLedTest1();
+      startDisplayAnimation(&LED_TEST_1_ANIMATION);
       break;
     case UTILITY_MODE_LED_TEST_2:
-      runLedTest2();
+      startDisplayAnimation(&LED_TEST_2_ANIMATION);
+      break;
+    case UTILITY_MODE_LED_CALIBRATION:
+      startLedCalibration();
       break;
     default:
       break;
@@ -266,7 +695,7 @@ void updateClockFaceEffectMode(uint8_t brightness) {
     default:
       clockFrameBuffers.getFaceInnerRingBuffer()->initializeFade(CLOCK_ANIM_RING_FADE_TIME);
       clockFrameBuffers.getFaceOuterRingBuffer()->initializeFade(CLOCK_ANIM_RING_FADE_TIME);
-      updateClockRingFadeTargets(timekeeper.getTime().hour(), brightness);
+      updateClockRingFadeTargets(brightness);
       clockFrameBuffers.getFaceInnerRingBuffer()->accelerateFadeToEnd();
       clockFrameBuffers.getFaceOuterRingBuffer()->accelerateFadeToEnd();
       break;
@@ -274,26 +703,13 @@ void updateClockFaceEffectMode(uint8_t brightness) {
 }
 
 /**
- * Updates the animation that plays while the time is being actively set
- */
-void updateTimeSetAnimation() {
-  clockFrameBuffers.getFaceInnerRingBuffer()->setAllValues(255 - clockSetAnimationValue);
-  clockFrameBuffers.getFaceOuterRingBuffer()->setAllValues(clockSetAnimationValue);
-  clockSetAnimationValue += clockSetAnimationDirection * 2;
-  if (clockSetAnimationValue == 0 || clockSetAnimationValue == 250) {
-    clockSetAnimationDirection = -clockSetAnimationDirection;
-  }
-}
-
-/**
- * Updates the clock ring fade targets
+ * Updates the clock ring fade targets from the (per-minute cached) sunrise/sunset schedule
  * 
- * @param hour The current hour
  * @param brightness The brightness
  */
-inline void updateClockRingFadeTargets(uint8_t hour, uint8_t brightness) {
-    clockFrameBuffers.getFaceInnerRingBuffer()->setFadeTarget(multiplyBrightness(pgm_read_byte(FACE_INNER_HOURLY_BRIGHTNESS + hour), brightness));
-    clockFrameBuffers.getFaceOuterRingBuffer()->setFadeTarget(multiplyBrightness(pgm_read_byte(FACE_OUTER_HOURLY_BRIGHTNESS + hour), brightness));
+inline void updateClockRingFadeTargets(uint8_t brightness) {
+    clockFrameBuffers.getFaceInnerRingBuffer()->setFadeTarget(multiplyBrightness(sunSchedule.getFaceInnerBrightness(), brightness));
+    clockFrameBuffers.getFaceOuterRingBuffer()->setFadeTarget(multiplyBrightness(sunSchedule.getFaceOuterBrightness(), brightness));
 }
 
 /**
@@ -305,55 +721,102 @@ inline uint8_t multiplyBrightness(uint8_t value, uint8_t brightness) {
 
 
 /**
- * A sort of self-test which fades all of the LEDs in and out
+ * Returns true if an animation or the LED calibration has taken over the display (the display mode and the fades leave
+ * the base layer alone until it ends)
  */
-void runLEDFadeTest() {
-  for (uint16_t i = 0; i < 256; i += 4) {
-    clockDisplay.setAllLEDValues(static_cast<uint8_t>(i));
-    clockDisplay.display();
-  }
-  clockDisplay.setAllLEDValues(255);
-  for (uint16_t i = 0; i < 60; ++i) {
-    clockDisplay.display();
-  }
-  for (uint16_t i = 0; i < 256; i += 4) {
-    clockDisplay.setAllLEDValues(255 - static_cast<uint8_t>(i));
-    clockDisplay.display();
-  }
-  clockDisplay.setAllLEDValues(0);
+inline bool isDisplayTakenOver() {
+  return displayAnimation.isPlaying() || ledCalibrationActive;
+}
+
+/**
+ * Takes over the whole display: the base layer is cleared and the layers above it hidden
+ */
+void takeOverDisplay() {
+  clockFrameBuffers.getBaseBuffer()->setAllValues(0);
+  clockCompositor.setLayerEnabled(CLOCK_LAYER_FACE, false);
+  clockCompositor.setLayerEnabled(CLOCK_LAYER_OVERLAY, false);
+  clockCompositor.setLayerEnabled(CLOCK_LAYER_MENU, false);
 }
 
 /**
- * LED test 1 - Show all LEDs at full intensity
+ * Hands the base layer back to the display mode
  */
-void runLedTest1() {
-  clockDisplay.setAllLEDValues(255);
-  while (options.getCurrentUtilityMode() != UTILITY_MODE_NONE) {
-    menu.update();
-    clockDisplay.display();
+void handBackDisplay() {
+  clockFrameBuffers.getBaseBuffer()->setAllValues(0);
+  clockCompositor.setLayerEnabled(CLOCK_LAYER_FACE, true);
+}
+
+/**
+ * Starts an animation which takes over the whole display (the startup animation or an LED test)
+ */
+void startDisplayAnimation(const AnimationScript *script) {
+  displayAnimation.play(script);
+  takeOverDisplay();
+}
+
+/**
+ * Ends the animation which took over the display
+ */
+void endDisplayAnimation() {
+  displayAnimation.stop();
+  handBackDisplay();
+}
+
+/**
+ * LED calibration - Steps through the LEDs, lighting each one (trimmed) at full intensity next to the previous one.
+ * "Select" moves to the next LED, "Enter" dims the current LED by one step (wrapping back to full intensity), and pressing both ends calibration.
+ * It takes over the base layer like the LED tests; the menu task reads the buttons (see updateLedCalibration()) and the
+ * compositor applies the trims, so the rest of the clock keeps running.
+ */
+void startLedCalibration() {
+  if (!ledCalibrationActive) {
+    ledCalibrationActive = true;
+    ledCalibrationIndex = 0;
+
+    // The button which selected the calibration is still held
+    ledCalibrationSelectPressed = true;
+    ledCalibrationEnterPressed = true;
+
+    takeOverDisplay();
+    showCalibrationLEDs(ledCalibrationIndex, true);
   }
-  clockDisplay.setAllLEDValues(0);
 }
 
 /**
- * LED test 2 - Show each LED at full intensity in sequence
+ * Ends the LED calibration, handing the display back
  */
-void runLedTest2() {
-  uint8_t i = 0;
-  uint16_t timer = 0;
-  clockDisplay.setAllLEDValues(0);
-  clockDisplay.setLEDValue(i, 255);
-  while (options.getCurrentUtilityMode() != UTILITY_MODE_NONE) {
-    menu.update();
-    clockDisplay.display();
+void endLedCalibration() {
+  ledCalibrationActive = false;
+  handBackDisplay();
+}
 
-    ++timer;
-    if (timer >= 1024) {
-      clockDisplay.setLEDValue(i, 0);
-      i = (i + 1) % CLOCK_DISPLAY_LED_COUNT;
-      clockDisplay.setLEDValue(i, 255);
-      timer = 0;
-    }
+/**
+ * Reads the buttons and acts on their presses (called by the menu task instead of updating the menu)
+ */
+void updateLedCalibration() {
+  menu.updateButtons();
+  bool selectPressed = menu.isSelectPressed();
+  bool enterPressed = menu.isEnterPressed();
+  if (selectPressed && enterPressed) {
+    options.setCurrentUtilityMode(UTILITY_MODE_NONE);
+  } else if (selectPressed && !ledCalibrationSelectPressed) {
+    showCalibrationLEDs(ledCalibrationIndex, false);
+    ledCalibrationIndex = (ledCalibrationIndex + 1) % CLOCK_DISPLAY_LED_COUNT;
+    showCalibrationLEDs(ledCalibrationIndex, true);
+  } else if (enterPressed && !ledCalibrationEnterPressed) {
+    uint8_t trim = clockDisplay.getLEDTrim(ledCalibrationIndex);
+    clockDisplay.setLEDTrim(ledCalibrationIndex, trim < CLOCK_DISPLAY_TRIM_STEP ? 255 : trim - CLOCK_DISPLAY_TRIM_STEP);
+    clockCompositor.invalidate(); // The layer values didn't change, but their trimmed values did
   }
-  clockDisplay.setAllLEDValues(0);
+  ledCalibrationSelectPressed = selectPressed;
+  ledCalibrationEnterPressed = enterPressed;
+}
+
+/**
+ * Lights (or clears) the given LED and the one before it on the base layer (the compositor applies their trims)
+ */
+void showCalibrationLEDs(ClockDisplayIndex index, bool lit) {
+  ClockDisplayIndex previousIndex = (index + CLOCK_DISPLAY_LED_COUNT - 1) % CLOCK_DISPLAY_LED_COUNT;
+  clockFrameBuffers.getBaseBuffer()->setValue(previousIndex, lit ? 255 : 0);
+  clockFrameBuffers.getBaseBuffer()->setValue(index, lit ? 255 : 0);
 }
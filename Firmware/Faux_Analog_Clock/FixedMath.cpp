@@ -0,0 +1,38 @@
+#include "Arduino.h"
+#include "ConstexprTable.h"
+#include "FixedMath.h"
+
+typedef ConstexprTable<SineQuarterTableGenerator> SineQuarterTable;
+
+const uint8_t SINE_TABLE_SHIFT = 14 - SINE_TABLE_BITS;
+
+int16_t fixedSin(uint16_t angle) {
+  uint16_t quarterAngle = angle & 0x3fff;
+  if ((angle & 0x4000) != 0) {
+    quarterAngle = 0x4000 - quarterAngle;
+  }
+
+  uint16_t index = quarterAngle >> SINE_TABLE_SHIFT;
+  int16_t value = pgm_read_word(SineQuarterTable::values + index);
+  if (index < SineQuarterTableGenerator::SIZE - 1) {
+    int16_t nextValue = pgm_read_word(SineQuarterTable::values + index + 1);
+    uint16_t fraction = quarterAngle & ((1 << SINE_TABLE_SHIFT) - 1);
+    value += static_cast<int16_t>((static_cast<int32_t>(nextValue - value) * fraction) >> SINE_TABLE_SHIFT);
+  }
+
+  return (angle & 0x8000) != 0 ? -value : value;
+}
+
+uint16_t fixedAcos(int16_t value) {
+  uint16_t low = 0;
+  uint16_t high = 0x8000;
+  while (high - low > 1) {
+    uint16_t middle = (low + high) >> 1;
+    if (fixedCos(middle) > value) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
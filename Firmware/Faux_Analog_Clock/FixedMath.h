@@ -0,0 +1,48 @@
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+#include "Arduino.h"
+#include "ConstexprTable.h"
+
+/*
+ * Fixed point trigonometry:
+ *   Angles are binary angles (65536 = one full turn)
+ *   Sine/cosine values are Q14 (16384 = 1.0)
+ */
+
+/**
+ * The quarter wave sine table has 2^SINE_TABLE_BITS steps (between 1 and 14)
+ */
+const uint8_t SINE_TABLE_BITS = 5;
+
+static_assert(SINE_TABLE_BITS >= 1 && SINE_TABLE_BITS <= 14, "SINE_TABLE_BITS must be between 1 and 14");
+
+/**
+ * Generates sin(0..90 degrees) in 2^SINE_TABLE_BITS steps
+ */
+struct SineQuarterTableGenerator {
+  typedef int16_t Type;
+  static const uint16_t SIZE = (1 << SINE_TABLE_BITS) + 1;
+  static constexpr Type value(uint16_t index) {
+    return static_cast<Type>(constexprRound(16384 * constexprSin(CONSTEXPR_PI / 2 * index / (SIZE - 1))));
+  }
+};
+
+/**
+ * Fixed point sine (linearly interpolated from the quarter wave table)
+ */
+int16_t fixedSin(uint16_t angle);
+
+/**
+ * Fixed point cosine
+ */
+inline int16_t fixedCos(uint16_t angle) {
+  return fixedSin(angle + 0x4000);
+}
+
+/**
+ * Fixed point arc cosine (binary search over fixedCos), returning an angle between 0 and 180 degrees
+ */
+uint16_t fixedAcos(int16_t value);
+
+#endif
@@ -1,9 +1,14 @@
 #include "Arduino.h"
 #include "FrameBufferView.h"
+#include "ClockTime.h"
+#include "Kernels.h"
 
-FrameBufferView::FrameBufferView(uint8_t *frameBuffer, uint8_t count) {
+template<typename Index>
+BasicFrameBufferView<Index>::BasicFrameBufferView(uint8_t *frameBuffer, Index count, FrameBufferDirtyRange<Index> *dirtyRange, Index dirtyOffset) {
   this->frameBuffer = frameBuffer;
   this->count = count;
+  this->dirtyRange = dirtyRange;
+  this->dirtyOffset = dirtyOffset;
 
   microsecondsPerFadeTick = 0;
   targetFadeValue = 0;
@@ -11,36 +16,53 @@ FrameBufferView::FrameBufferView(uint8_t *frameBuffer, uint8_t count) {
   isFadeActive = false;
   lastFadeActive = false;
   lastFadeTimestamp = 0;
+
+  fadeStartValues = NULL;
+  fadeStartTimestamp = 0;
+  lastFadeAmount = 0;
+}
+
+template<typename Index>
+BasicFrameBufferView<Index>::~BasicFrameBufferView() {
+  delete[] fadeStartValues;
 }
 
-void FrameBufferView::setValue(uint8_t index, uint8_t value) {
-  if (index < count) {
+template<typename Index>
+void BasicFrameBufferView<Index>::setValue(Index index, uint8_t value) {
+  catchUpTimedFade();
+  if (index < count && frameBuffer[index] != value) {
     frameBuffer[index] = value;
-    isFadeActive = microsecondsPerFadeTick > 0;
+    valuesChanged(index, index + 1);
   }
 }
 
-void FrameBufferView::setValues(uint8_t startIndex, uint8_t valueCount, uint8_t value) {
+template<typename Index>
+void BasicFrameBufferView<Index>::setValues(Index startIndex, Index valueCount, uint8_t value) {
   if (startIndex < count) {
-    uint8_t realCount = min(count - startIndex, valueCount);
+    Index realCount = min(count - startIndex, valueCount);
     if (realCount > 0) {
+      catchUpTimedFade();
       memset(frameBuffer + startIndex, value, realCount);
-      isFadeActive = microsecondsPerFadeTick > 0;
+      valuesChanged(startIndex, startIndex + realCount);
     }
   }
 }
 
-void FrameBufferView::setAllValues(uint8_t value) {
+template<typename Index>
+void BasicFrameBufferView<Index>::setAllValues(uint8_t value) {
+  catchUpTimedFade();
   memset(frameBuffer, value, count);
-  isFadeActive = microsecondsPerFadeTick > 0;
+  valuesChanged();
 }
 
-void FrameBufferView::setValuesBinaryDisplay(uint8_t bitValue, uint8_t bitCount, uint8_t valuesPerBit, bool setZeroes, uint8_t intensity) {
+template<typename Index>
+void BasicFrameBufferView<Index>::setValuesBinaryDisplay(uint8_t bitValue, uint8_t bitCount, Index valuesPerBit, bool setZeroes, uint8_t intensity) {
   // Sanity checks
   uint8_t realBitCount = min(max(bitCount, 1), 8);
-  uint8_t realValuesPerBit = min(max(valuesPerBit, 1), count / realBitCount);
+  Index realValuesPerBit = min(max(valuesPerBit, 1), count / realBitCount);
 
   // Set values
+  catchUpTimedFade();
   uint8_t remainingValue = bitValue;
   uint8_t *target = frameBuffer;
   for (uint8_t i = 0; i < realBitCount; ++i) {
@@ -54,30 +76,165 @@ void FrameBufferView::setValuesBinaryDisplay(uint8_t bitValue, uint8_t bitCount,
     remainingValue >>= 1;
   }
   
-  isFadeActive = microsecondsPerFadeTick > 0;
+  valuesChanged(0, static_cast<Index>(target - frameBuffer));
+}
+
+template<typename Index>
+Index BasicFrameBufferView<Index>::getCount() const {
+  return count;
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::setArc(Index startIndex, Index length, uint8_t value) {
+  if (count > 0) {
+    Index realStartIndex = wrapIndex(startIndex);
+    Index realLength = min(length, count);
+    Index firstRunLength = min(realLength, count - realStartIndex);
+    if (realLength > 0) {
+      catchUpTimedFade();
+      memset(frameBuffer + realStartIndex, value, firstRunLength);
+      if (realLength > firstRunLength) {
+        memset(frameBuffer, value, realLength - firstRunLength);
+        markDirty(0, realLength - firstRunLength);
+      }
+      valuesChanged(realStartIndex, realStartIndex + firstRunLength);
+    }
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::setMirroredArc(Index startIndex, Index length, uint8_t value) {
+  if (count > 0 && length > 0) {
+    // A counterclockwise arc is the clockwise arc ending at the start index
+    Index realStartIndex = wrapIndex(startIndex);
+    Index realLength = min(length, count);
+    Index backLength = realLength - 1;
+    setArc(realStartIndex >= backLength ? realStartIndex - backLength : realStartIndex + count - backLength, realLength, value);
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::setScaledArc(Index startIndex, Index length, Index resolution, uint8_t value) {
+  if (resolution == count || resolution == 0) {
+    setArc(startIndex, length, value);
+  } else {
+    WideIndex scaledStart = static_cast<WideIndex>(startIndex) * count / resolution;
+    WideIndex scaledEnd = (static_cast<WideIndex>(startIndex) + length) * count / resolution;
+    setArc(static_cast<Index>(scaledStart), static_cast<Index>(min(scaledEnd - scaledStart, count)), value);
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::setSteppedGradient(Index startIndex, Index length, uint8_t steps, uint8_t startValue, uint8_t endValue) {
+  Index realLength = min(length, count);
+  uint8_t realSteps = static_cast<uint8_t>(min(max(steps, 1), max(realLength, 1)));
+  int16_t valueRange = static_cast<int16_t>(endValue) - static_cast<int16_t>(startValue);
+
+  Index stepStart = 0;
+  for (uint8_t i = 0; i < realSteps; ++i) {
+    Index stepEnd = static_cast<Index>(static_cast<WideIndex>(realLength) * (i + 1) / realSteps);
+    int16_t stepValue = realSteps > 1 ? startValue + valueRange * i / (realSteps - 1) : startValue;
+    setArc(startIndex + stepStart, stepEnd - stepStart, static_cast<uint8_t>(stepValue));
+    stepStart = stepEnd;
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::copyRotated(const BasicFrameBufferView &source, Index rotation) {
+  if (count > 0 && source.count == count) {
+    Index realRotation = wrapIndex(rotation);
+    catchUpTimedFade();
+    memcpy(frameBuffer + realRotation, source.frameBuffer, count - realRotation);
+    memcpy(frameBuffer, source.frameBuffer + count - realRotation, realRotation);
+    valuesChanged();
+  }
 }
 
-void FrameBufferView::initializeFade(uint32_t microsecondsPerFadeTick, uint8_t targetFadeValue) {
+template<typename Index>
+void BasicFrameBufferView<Index>::blendValues(const uint8_t *source, Index startIndex, Index valueCount, uint8_t brightness, uint8_t blendMode) {
+  if (startIndex >= count) {
+    return;
+  }
+  Index realCount = min(count - startIndex, valueCount);
+  uint8_t *target = frameBuffer + startIndex;
+  catchUpTimedFade();
+
+  if (blendMode == BLEND_MODE_REPLACE && brightness == 255) {
+    memcpy(target, source, realCount);
+  } else {
+    for (Index i = 0; i < realCount; ++i) {
+      uint8_t value = source[i];
+      if (brightness < 255) {
+        value = static_cast<uint8_t>(static_cast<uint16_t>(value) * brightness / 255);
+      }
+
+      if (blendMode == BLEND_MODE_MAX) {
+        target[i] = max(target[i], value);
+      } else if (blendMode == BLEND_MODE_ADD) {
+        target[i] = static_cast<uint8_t>(min(static_cast<uint16_t>(target[i]) + value, 255));
+      } else {
+        target[i] = value;
+      }
+    }
+  }
+
+  valuesChanged(startIndex, startIndex + realCount);
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::initializeFade(uint32_t microsecondsPerFadeTick, uint8_t targetFadeValue) {
+  catchUpTimedFade();
   this->microsecondsPerFadeTick = microsecondsPerFadeTick;
   this->targetFadeValue = targetFadeValue;
   
   isFadeActive = microsecondsPerFadeTick > 0;
+  if (fadeStartValues != NULL) {
+    fadingRange.clear();
+    if (isFadeActive) {
+      fadingRange.merge(0, count);
+    }
+    restartTimedFade(clockMicros());
+  }
 }
 
-void FrameBufferView::initializeFade(uint32_t microsecondsPerFadeTick) {
-  this->microsecondsPerFadeTick = microsecondsPerFadeTick;
-  
-  isFadeActive = microsecondsPerFadeTick > 0;
+template<typename Index>
+void BasicFrameBufferView<Index>::initializeFade(uint32_t microsecondsPerFadeTick) {
+  initializeFade(microsecondsPerFadeTick, targetFadeValue);
 }
 
-void FrameBufferView::setFadeTarget(uint8_t targetFadeValue) {
+template<typename Index>
+void BasicFrameBufferView<Index>::setFadeTarget(uint8_t targetFadeValue) {
+  if (fadeStartValues != NULL) {
+    // A timed fade only needs restarting if the target moved
+    if (targetFadeValue != this->targetFadeValue) {
+      catchUpTimedFade();
+      this->targetFadeValue = targetFadeValue;
+      valuesChanged();
+    }
+    return;
+  }
+
   this->targetFadeValue = targetFadeValue;
   isFadeActive = microsecondsPerFadeTick > 0;
 }
 
-void FrameBufferView::updateFade() {
-  if (isFadeActive) {
-    uint32_t timestamp = micros();
+template<typename Index>
+void BasicFrameBufferView<Index>::enableTimedFade() {
+  if (fadeStartValues == NULL && count > 0) {
+    fadeStartValues = new uint8_t[count];
+    if (isFadeActive) {
+      fadingRange.merge(0, count);
+    }
+    restartTimedFade(clockMicros());
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::updateFade() {
+  if (fadeStartValues != NULL) {
+    catchUpTimedFade();
+  } else if (isFadeActive) {
+    uint32_t timestamp = clockMicros();
     bool firstFadeTick = !lastFadeActive;
 
     if (firstFadeTick) {
@@ -89,25 +246,13 @@ void FrameBufferView::updateFade() {
       uint32_t fadeRateLong = (timestamp - lastFadeTimestamp) / microsecondsPerFadeTick;
       lastFadeTimestamp += fadeRateLong * microsecondsPerFadeTick;
 
-      uint8_t fadeRate = static_cast<uint8_t>(min(fadeRateLong, 255));
+      uint8_t fadeRate = static_cast<uint8_t>(min(fadeRateLong, 255UL));
       if (fadeRate > 0) {
         // Fade buffer
-        isFadeActive = false;
-        uint8_t *currentBuffer = frameBuffer;
-        for (uint8_t i = 0; i < count; ++i) {
-          uint8_t value = *currentBuffer;
-          if (value != targetFadeValue) {
-            if (value > targetFadeValue) {
-              // If value is greater than the target value, decrease it
-              *currentBuffer -= min(fadeRate, value - targetFadeValue);
-            } else {
-              // If value is less than the target value, increase it
-              *currentBuffer += min(fadeRate, targetFadeValue - value);
-            }
-            isFadeActive = true;
-          }
-          
-          ++currentBuffer;
+        uint8_t fadeFlags = fadeValues(frameBuffer, frameBuffer, count, targetFadeValue, fadeRate);
+        isFadeActive = (fadeFlags & FADE_VALUES_ACTIVE) != 0;
+        if ((fadeFlags & FADE_VALUES_CHANGED) != 0) {
+          markDirty();
         }
       }
     }
@@ -115,9 +260,97 @@ void FrameBufferView::updateFade() {
   lastFadeActive = isFadeActive;
 }
 
-void FrameBufferView::accelerateFadeToEnd() {
+template<typename Index>
+void BasicFrameBufferView<Index>::accelerateFadeToEnd() {
   if (isFadeActive) {
     memset(frameBuffer, targetFadeValue, count);
     isFadeActive = false;
+    fadingRange.clear();
+    markDirty();
   }
 }
+
+template<typename Index>
+void BasicFrameBufferView<Index>::catchUpTimedFade() {
+  if (fadeStartValues != NULL && isFadeActive) {
+    evaluateTimedFade(clockMicros());
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::valuesChanged() {
+  valuesChanged(0, count);
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::valuesChanged(Index startIndex, Index endIndex) {
+  isFadeActive = microsecondsPerFadeTick > 0;
+  if (fadeStartValues != NULL && isFadeActive) {
+    // Keep the time already spent in the current fade step, so frequent changes don't hold the fade back
+    uint32_t timestamp = clockMicros();
+    if (!fadingRange.isEmpty()) {
+      timestamp -= (timestamp - fadeStartTimestamp) % microsecondsPerFadeTick;
+    }
+    fadingRange.merge(startIndex, endIndex);
+    restartTimedFade(timestamp);
+  }
+  markDirty(startIndex, endIndex);
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::restartTimedFade(uint32_t timestamp) {
+  if (fadeStartValues != NULL) {
+    // Values outside the fading range are at the target, so their start values don't matter
+    if (!fadingRange.isEmpty()) {
+      memcpy(fadeStartValues + fadingRange.start, frameBuffer + fadingRange.start, fadingRange.end - fadingRange.start);
+    }
+    fadeStartTimestamp = timestamp;
+    lastFadeAmount = 0;
+  }
+}
+
+template<typename Index>
+void BasicFrameBufferView<Index>::evaluateTimedFade(uint32_t timestamp) {
+  // Every value moves toward the target by the number of whole fade ticks since the start of the fade (nothing changes
+  // until another tick has passed)
+  uint32_t fadeAmountLong = (timestamp - fadeStartTimestamp) / microsecondsPerFadeTick;
+  uint8_t fadeAmount = static_cast<uint8_t>(min(fadeAmountLong, 255UL));
+  if (fadeAmount == lastFadeAmount) {
+    return;
+  }
+  lastFadeAmount = fadeAmount;
+
+  // Only the values which haven't reached the target yet are computed
+  Index start = fadingRange.start;
+  Index end = fadingRange.end;
+  uint8_t fadeFlags = fadeValues(frameBuffer + start, fadeStartValues + start, end - start, targetFadeValue, fadeAmount);
+  if ((fadeFlags & FADE_VALUES_CHANGED) != 0) {
+    markDirty(start, end);
+  }
+  if ((fadeFlags & FADE_VALUES_ACTIVE) == 0) {
+    fadingRange.clear();
+    isFadeActive = false;
+  } else {
+    // Leave out the values which have reached the target at either end of the range
+    while (frameBuffer[start] == targetFadeValue) {
+      ++start;
+    }
+    while (frameBuffer[end - 1] == targetFadeValue) {
+      --end;
+    }
+    fadingRange.start = start;
+    fadingRange.end = end;
+  }
+}
+
+template<typename Index>
+Index BasicFrameBufferView<Index>::wrapIndex(Index index) const {
+  while (index >= count) {
+    index -= count;
+  }
+  return index;
+}
+
+// Views of up to 255 values (the clock's rings and displays), and of larger displays
+template class BasicFrameBufferView<uint8_t>;
+template class BasicFrameBufferView<uint16_t>;
@@ -3,15 +3,90 @@
 
 #include "Arduino.h"
 
-class FrameBufferView {
+/**
+ * Blend modes used by FrameBufferView::blendValues()
+ */
+const uint8_t BLEND_MODE_REPLACE = 0;
+const uint8_t BLEND_MODE_MAX = 1;
+const uint8_t BLEND_MODE_ADD = 2;
+
+/**
+ * Index types a frame buffer view can use, each with an integer type wide enough for products of two indices
+ */
+template<typename Index>
+struct FrameBufferIndexTraits;
+
+template<>
+struct FrameBufferIndexTraits<uint8_t> {
+  typedef uint16_t WideIndex;
+};
+
+template<>
+struct FrameBufferIndexTraits<uint16_t> {
+  typedef uint32_t WideIndex;
+};
+
+/**
+ * A range of modified frame buffer indices, from start (inclusive) to end (exclusive)
+ */
+template<typename Index>
+struct FrameBufferDirtyRange {
+  Index start;
+  Index end;
+
+  FrameBufferDirtyRange() {
+    clear();
+  }
+
+  /**
+   * Empties the range
+   */
+  void clear() {
+    start = static_cast<Index>(~static_cast<Index>(0));
+    end = 0;
+  }
+
+  /**
+   * Returns true if no index has been modified
+   */
+  bool isEmpty() const {
+    return start >= end;
+  }
+
+  /**
+   * Grows the range to include the given indices
+   */
+  void merge(Index start, Index end) {
+    if (start < end) {
+      this->start = min(this->start, start);
+      this->end = max(this->end, end);
+    }
+  }
+};
+
+/**
+ * A view of a run of frame buffer values.
+ * Index is the type of indices and counts (uint8_t for views of up to 255 values, uint16_t for larger displays).
+ */
+template<typename Index>
+class BasicFrameBufferView {
 public:
+  typedef typename FrameBufferIndexTraits<Index>::WideIndex WideIndex;
+
   /**
    * Creates a frame buffer view which operates on the given frame buffer data
    * 
    * @param frameBuffer The frame buffer data
    * @param count The number of items in the frame buffer
+   * @param dirtyRange If not NULL, the indices modified by the view are merged into this range
+   * @param dirtyOffset The index of the view's first value within the dirty range's indices
+   */
+  BasicFrameBufferView(uint8_t *frameBuffer, Index count, FrameBufferDirtyRange<Index> *dirtyRange = NULL, Index dirtyOffset = 0);
+
+  /**
+   * Deletes the timed fade start values (if any)
    */
-  FrameBufferView(uint8_t *frameBuffer, uint8_t count);
+  ~BasicFrameBufferView();
 
   /**
    * Sets the value at the given index in the frame buffer
@@ -19,7 +94,7 @@ public:
    * @param index The index to set
    * @param value The value to set
    */
-  void setValue(uint8_t index, uint8_t value);
+  void setValue(Index index, uint8_t value);
 
   /**
    * Sets multiple values at once
@@ -28,7 +103,7 @@ public:
    * @param valueCount The number of values to set
    * @param value The value to set
    */
-  void setValues(uint8_t startIndex, uint8_t valueCount, uint8_t value);
+  void setValues(Index startIndex, Index valueCount, uint8_t value);
 
   /**
    * Sets all values in the frame buffer
@@ -46,7 +121,75 @@ public:
    * @param setZeroes If true, zeroes are set (false for better fade effects)
    * @param intensity The intensity of the display (the value to set for each frame buffer element)
    */
-  void setValuesBinaryDisplay(uint8_t bitValue, uint8_t bitCount, uint8_t valuesPerBit, bool setZeroes, uint8_t intensity);
+  void setValuesBinaryDisplay(uint8_t bitValue, uint8_t bitCount, Index valuesPerBit, bool setZeroes, uint8_t intensity);
+
+  /**
+   * Gets the number of items in the frame buffer
+   */
+  Index getCount() const;
+
+  /*
+   * Ring drawing primitives.
+   * These treat the buffer as a ring (index 0 follows the last index) and write at most two contiguous runs each.
+   */
+
+  /**
+   * Sets an arc of values, clockwise (increasing index) from the start index, wrapping around the end of the ring
+   * 
+   * @param startIndex The first index of the arc (wrapped into the ring)
+   * @param length The number of values to set (at most the size of the ring)
+   * @param value The value to set
+   */
+  void setArc(Index startIndex, Index length, uint8_t value);
+
+  /**
+   * Sets an arc of values, counterclockwise (decreasing index) from the start index, wrapping around the start of the ring
+   * 
+   * @param startIndex The first index of the arc (wrapped into the ring)
+   * @param length The number of values to set (at most the size of the ring)
+   * @param value The value to set
+   */
+  void setMirroredArc(Index startIndex, Index length, uint8_t value);
+
+  /**
+   * Sets an arc given in the positions of a ring of another resolution (e.g. hours on a 60 value ring)
+   * 
+   * @param startIndex The first index of the arc, in source ring positions
+   * @param length The length of the arc, in source ring positions
+   * @param resolution The number of positions in the source ring
+   * @param value The value to set
+   */
+  void setScaledArc(Index startIndex, Index length, Index resolution, uint8_t value);
+
+  /**
+   * Sets a stepped gradient arc, clockwise from the start index (one arc per step)
+   * 
+   * @param startIndex The first index of the gradient
+   * @param length The number of values covered by the gradient
+   * @param steps The number of distinct values in the gradient
+   * @param startValue The value of the first step
+   * @param endValue The value of the last step
+   */
+  void setSteppedGradient(Index startIndex, Index length, uint8_t steps, uint8_t startValue, uint8_t endValue);
+
+  /**
+   * Copies the values of another ring of the same size, rotated clockwise
+   * 
+   * @param source The ring to copy
+   * @param rotation The number of positions by which to rotate the copied values
+   */
+  void copyRotated(const BasicFrameBufferView &source, Index rotation);
+
+  /**
+   * Blends values from the given source into the frame buffer
+   * 
+   * @param source The values to blend
+   * @param startIndex The first index to blend into
+   * @param valueCount The number of values to blend
+   * @param brightness The brightness by which the source values are multiplied
+   * @param blendMode How the source values are combined with the frame buffer (see BLEND_MODE_*)
+   */
+  void blendValues(const uint8_t *source, Index startIndex, Index valueCount, uint8_t brightness, uint8_t blendMode);
 
   /**
    * Sets this buffer up to be fadeable by calling the updateFade() method
@@ -70,6 +213,16 @@ public:
    */
   void setFadeTarget(uint8_t targetFadeValue);
 
+  /**
+   * Switches this buffer to timed fades (uses count more bytes of RAM).
+   * Rather than stepping the values on every updateFade(), the values and time at which the fade started are kept,
+   * and the current values are computed from them when they're needed (by updateFade(), or before a write), so the fade
+   * doesn't depend on how often (or whether) updateFade() is called.
+   * Only the range of values which haven't reached the target is computed, and only once another fade tick has passed;
+   * a view whose values are all at the target costs nothing.
+   */
+  void enableTimedFade();
+
   /**
    * Updates the buffer fade if required
    */
@@ -82,7 +235,9 @@ public:
 
 private:
   uint8_t *frameBuffer;
-  uint8_t count;
+  Index count;
+  FrameBufferDirtyRange<Index> *dirtyRange;
+  Index dirtyOffset;
 
   uint32_t microsecondsPerFadeTick;
   uint8_t targetFadeValue;
@@ -90,6 +245,71 @@ private:
   bool isFadeActive;
   bool lastFadeActive;
   uint32_t lastFadeTimestamp;
+
+  // Timed fades only (fadeStartValues is NULL otherwise)
+  uint8_t *fadeStartValues;
+  uint32_t fadeStartTimestamp;
+  uint8_t lastFadeAmount;
+  FrameBufferDirtyRange<Index> fadingRange; // The values which haven't reached the target (view indices)
+
+  /**
+   * Brings the values of a timed fade up to date (call before modifying the frame buffer)
+   */
+  void catchUpTimedFade();
+
+  /**
+   * Starts the fade again from the current values (call after modifying the frame buffer or the fade target)
+   * 
+   * @param startIndex The first modified index
+   * @param endIndex The index following the last modified index
+   */
+  void valuesChanged(Index startIndex, Index endIndex);
+
+  /**
+   * Starts the fade again from the current values, with the whole frame buffer modified
+   */
+  void valuesChanged();
+
+  /**
+   * Restarts a timed fade from the current values (of the fading range)
+   * 
+   * @param timestamp The time at which the fade starts
+   */
+  void restartTimedFade(uint32_t timestamp);
+
+  /**
+   * Computes the values of a timed fade at the given time (if another fade tick has passed)
+   */
+  void evaluateTimedFade(uint32_t timestamp);
+
+  /**
+   * Wraps the given index into the ring
+   */
+  Index wrapIndex(Index index) const;
+
+  /**
+   * Flags a range of the frame buffer as modified
+   * 
+   * @param startIndex The first modified index
+   * @param endIndex The index following the last modified index
+   */
+  inline void markDirty(Index startIndex, Index endIndex) {
+    if (dirtyRange != NULL) {
+      dirtyRange->merge(dirtyOffset + startIndex, dirtyOffset + endIndex);
+    }
+  }
+
+  /**
+   * Flags the whole frame buffer as modified
+   */
+  inline void markDirty() {
+    markDirty(0, count);
+  }
 };
 
+/**
+ * The view used for the clock's rings and displays
+ */
+typedef BasicFrameBufferView<uint8_t> FrameBufferView;
+
 #endif
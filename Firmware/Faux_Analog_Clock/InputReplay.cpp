@@ -0,0 +1,134 @@
+#include "Arduino.h"
+#include "InputReplay.h"
+#include "Trace.h"
+
+#ifdef CLOCK_VIRTUAL_TIME
+
+InputReplay inputReplay;
+
+InputReplay::InputReplay() {
+  data = NULL;
+  length = 0;
+  position = 0;
+  nextEventMillis = 0;
+  nextEventValid = false;
+  buttonPins = 0xff;
+  gpsData = NULL;
+  gpsDataCount = 0;
+  gpsDataReceived = 0;
+  gpsDataStartMicros = 0;
+  gpsBufferHead = 0;
+  gpsBufferCount = 0;
+  droppedGPSByteCount = 0;
+}
+
+bool InputReplay::begin(const uint8_t *data, uint32_t length) {
+  if (length < 5 || memcmp(data, "FACI", 4) != 0 || data[4] != INPUT_CAPTURE_VERSION) {
+    return false;
+  }
+  this->data = data;
+  this->length = length;
+  position = 5;
+  nextEventMillis = clockMillis();
+  readNextEventTime();
+  return true;
+}
+
+void InputReplay::update() {
+  while (nextEventValid && static_cast<int32_t>(clockMillis() - nextEventMillis) >= 0) {
+    uint8_t type = data[position++];
+    if (type == INPUT_EVENT_BUTTONS && position < length) {
+      buttonPins = data[position++];
+      TRACE(TRACE_EVENT_REPLAY_BUTTONS, buttonPins);
+    } else if (type == INPUT_EVENT_GPS && position < length) {
+      // A new transmission can only start once the previous one is over
+      receiveGPSBytes(true);
+      uint8_t count = data[position++];
+      gpsDataCount = static_cast<uint8_t>(min(static_cast<uint32_t>(count), length - position));
+      gpsData = data + position;
+      gpsDataReceived = 0;
+      gpsDataStartMicros = clockMicros();
+      position += gpsDataCount;
+      TRACE(TRACE_EVENT_REPLAY_GPS, gpsDataCount);
+    } else {
+      // Unknown or truncated event; stop replaying
+      position = length;
+    }
+    readNextEventTime();
+  }
+  receiveGPSBytes(false);
+}
+
+bool InputReplay::isFinished() const {
+  return !nextEventValid && gpsDataReceived == gpsDataCount;
+}
+
+uint8_t InputReplay::getButtonPins() {
+  update();
+  return buttonPins;
+}
+
+uint32_t InputReplay::getDroppedGPSByteCount() const {
+  return droppedGPSByteCount;
+}
+
+int InputReplay::available() {
+  update();
+  return gpsBufferCount;
+}
+
+int InputReplay::read() {
+  update();
+  if (gpsBufferCount == 0) {
+    return -1;
+  }
+  uint8_t value = gpsBuffer[gpsBufferHead];
+  gpsBufferHead = (gpsBufferHead + 1) % INPUT_REPLAY_GPS_BUFFER_SIZE;
+  --gpsBufferCount;
+  return value;
+}
+
+int InputReplay::peek() {
+  update();
+  return gpsBufferCount > 0 ? gpsBuffer[gpsBufferHead] : -1;
+}
+
+size_t InputReplay::write(uint8_t /* value */) {
+  // Commands sent to the GPS are ignored
+  return 1;
+}
+
+void InputReplay::flush() {
+}
+
+
+void InputReplay::readNextEventTime() {
+  uint32_t delta = 0;
+  uint8_t shift = 0;
+  while (position < length) {
+    uint8_t value = data[position++];
+    delta |= static_cast<uint32_t>(value & 0x7f) << shift;
+    shift += 7;
+    if ((value & 0x80) == 0) {
+      nextEventMillis += delta;
+      nextEventValid = position < length;
+      return;
+    }
+  }
+  nextEventValid = false;
+}
+
+void InputReplay::receiveGPSBytes(bool all) {
+  uint32_t arrived = all ? gpsDataCount : (clockMicros() - gpsDataStartMicros) / INPUT_REPLAY_GPS_BYTE_MICROS + 1;
+  while (gpsDataReceived < gpsDataCount && gpsDataReceived < arrived) {
+    if (gpsBufferCount < INPUT_REPLAY_GPS_BUFFER_SIZE) {
+      gpsBuffer[(gpsBufferHead + gpsBufferCount) % INPUT_REPLAY_GPS_BUFFER_SIZE] = gpsData[gpsDataReceived];
+      ++gpsBufferCount;
+    } else {
+      ++droppedGPSByteCount;
+    }
+    ++gpsDataReceived;
+  }
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include "Arduino.h"
+#include "ClockTime.h"
+
+#ifdef CLOCK_VIRTUAL_TIME
+
+/*
+ * Replays captured inputs (button states and GPS bytes) on virtual time, in place of the button port and the GPS serial port.
+ *
+ * Capture format (Tools/input_capture.py converts between this and text):
+ *   "FACI", version (1 byte)
+ *   Events, each made of:
+ *     Milliseconds since the previous event (varint: 7 bits per byte, least significant first, high bit set if more bytes follow)
+ *     Event type (INPUT_EVENT_*)
+ *     INPUT_EVENT_BUTTONS: the button port (PINB) state (1 byte)
+ *     INPUT_EVENT_GPS: a byte count (1 byte), then the bytes received from the GPS (at 9600 baud, starting at the event time)
+ */
+
+const uint8_t INPUT_CAPTURE_VERSION = 1;
+const uint8_t INPUT_EVENT_BUTTONS = 1;
+const uint8_t INPUT_EVENT_GPS = 2;
+
+/**
+ * The size of the GPS receive buffer (the same as SoftwareSerial's; bytes arriving while it's full are dropped)
+ */
+const uint8_t INPUT_REPLAY_GPS_BUFFER_SIZE = 64;
+
+/**
+ * The time it takes the GPS to send one byte at 9600 baud, in microseconds
+ */
+const uint16_t INPUT_REPLAY_GPS_BYTE_MICROS = 1042;
+
+class InputReplay : public Stream {
+public:
+  InputReplay();
+
+  /**
+   * Starts replaying the given capture (which must stay valid while replaying), with its first event at the current clock time
+   *
+   * @return false if the data is not a capture
+   */
+  bool begin(const uint8_t *data, uint32_t length);
+
+  /**
+   * Applies all events up to the current clock time.
+   * The other methods do this themselves, but a harness should also call this after every loop() so that events are traced close to their capture times.
+   */
+  void update();
+
+  /**
+   * Returns true once every event has been applied and every GPS byte has been received
+   */
+  bool isFinished() const;
+
+  /**
+   * Gets the button port state (both buttons released until the first button event)
+   */
+  uint8_t getButtonPins();
+
+  /**
+   * Gets the number of GPS bytes dropped because the receive buffer was full
+   */
+  uint32_t getDroppedGPSByteCount() const;
+
+  // Stream (the GPS serial port)
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t value);
+  void flush();
+
+private:
+  const uint8_t *data;
+  uint32_t length;
+  uint32_t position;
+  uint32_t nextEventMillis;
+  bool nextEventValid;
+
+  uint8_t buttonPins;
+
+  const uint8_t *gpsData;
+  uint8_t gpsDataCount;
+  uint8_t gpsDataReceived;
+  uint32_t gpsDataStartMicros;
+
+  uint8_t gpsBuffer[INPUT_REPLAY_GPS_BUFFER_SIZE];
+  uint8_t gpsBufferHead;
+  uint8_t gpsBufferCount;
+  uint32_t droppedGPSByteCount;
+
+  /**
+   * Reads the time of the next event
+   */
+  void readNextEventTime();
+
+  /**
+   * Moves the GPS bytes which have arrived by now into the receive buffer
+   */
+  void receiveGPSBytes(bool all);
+};
+
+/**
+ * The input replay used by ClockMenu and Timekeeper in virtual time builds
+ */
+extern InputReplay inputReplay;
+
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#include "Arduino.h"
+#include "Kernels.h"
+
+#define NOP __asm__ __volatile__ ("nop\n\t")
+
+void waitIterations(uint8_t iterations) {
+  // 15 ms scan at a delay length of 1 NOP
+  // 18 ms scan at a delay length of 2 NOPs
+  // 21 ms scan at a delay length of 3 NOPs
+  // Basically 15 ms + 3 ms * (NOPs - 1)
+  for (uint8_t i = 0; i < iterations; ++i) {
+    NOP; NOP; NOP;
+  }
+}
+
+uint8_t fadeValues(uint8_t *destination, const uint8_t *source, uint16_t count, uint8_t targetValue, uint8_t amount) {
+  uint8_t flags = 0;
+  for (uint16_t i = 0; i < count; ++i) {
+    uint8_t value = source[i];
+    if (value > targetValue) {
+      // If value is greater than the target value, decrease it
+      value -= min(amount, value - targetValue);
+    } else {
+      // If value is less than the target value, increase it
+      value += min(amount, targetValue - value);
+    }
+
+    if (value != targetValue) {
+      flags |= FADE_VALUES_ACTIVE;
+    }
+    if (destination[i] != value) {
+      destination[i] = value;
+      flags |= FADE_VALUES_CHANGED;
+    }
+  }
+  return flags;
+}
@@ -0,0 +1,40 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "Arduino.h"
+
+/*
+ * Hot loop kernels (the display scan's on-time wait and the per-value fade step)
+ */
+
+/**
+ * The number of CPU cycles taken by four iterations of waitIterations() (measured from the scan time, so it's only
+ * approximate, and depends on the compiler version)
+ */
+const uint8_t WAIT_CYCLES_PER_4_ITERATIONS = 29;
+
+/**
+ * Flags returned by fadeValues()
+ */
+const uint8_t FADE_VALUES_ACTIVE = 0b00000001;  // At least one value has not reached the target
+const uint8_t FADE_VALUES_CHANGED = 0b00000010; // At least one value in the destination changed
+
+/**
+ * Busy-waits for the given number of iterations (see WAIT_CYCLES_PER_4_ITERATIONS)
+ */
+void waitIterations(uint8_t iterations);
+
+/**
+ * Moves each source value toward the target value by at most the given amount, storing the results in the destination
+ * (which may be the source)
+ *
+ * @param destination The values to store
+ * @param source The values to fade
+ * @param count The number of values
+ * @param targetValue The value to fade toward
+ * @param amount The largest change allowed in a value
+ * @return A combination of FADE_VALUES_* flags
+ */
+uint8_t fadeValues(uint8_t *destination, const uint8_t *source, uint16_t count, uint8_t targetValue, uint8_t amount);
+
+#endif
@@ -0,0 +1,51 @@
+#include "Arduino.h"
+#include "MemoryMonitor.h"
+
+MemoryStats memoryStats = { 0, 0, 0, 0xFFFF };
+
+#ifndef CLOCK_VIRTUAL_TIME
+
+extern uint8_t __data_start;
+extern uint8_t __heap_start;
+extern uint8_t *__brkval;
+
+/**
+ * Paints everything between the static data and the stack before any constructor runs (so before anything is allocated)
+ */
+extern "C" void memoryPaint() __attribute__((naked, used, section(".init3")));
+void memoryPaint() {
+  uint8_t *address = &__heap_start;
+  uint8_t *end = reinterpret_cast<uint8_t *>(SP);
+  while (address < end) {
+    *address++ = MEMORY_PAINT_VALUE;
+  }
+}
+
+void memoryMonitorUpdate() {
+  memoryMonitorMeasure(&__data_start, &__heap_start, __brkval != NULL ? __brkval : &__heap_start,
+    reinterpret_cast<uint8_t *>(SP), reinterpret_cast<uint8_t *>(RAMEND));
+}
+
+#else
+
+void memoryMonitorUpdate() {
+  // A host build has no AVR memory layout to measure
+}
+
+#endif
+
+void memoryMonitorMeasure(const uint8_t *dataStart, const uint8_t *heapStart, const uint8_t *heapEnd, const uint8_t *stackPointer, const uint8_t *ramEnd) {
+  // Everything from the heap up to the first overwritten byte has never been used by the stack
+  const uint8_t *address = heapEnd;
+  while (address < stackPointer && *address == MEMORY_PAINT_VALUE) {
+    ++address;
+  }
+
+  memoryStats.staticBytes = static_cast<uint16_t>(heapStart - dataStart);
+  memoryStats.heapBytes = static_cast<uint16_t>(heapEnd - heapStart);
+  memoryStats.stackBytes = static_cast<uint16_t>(ramEnd - address + 1);
+  uint16_t freeBytes = static_cast<uint16_t>(address - heapEnd);
+  if (freeBytes < memoryStats.minimumFreeBytes) {
+    memoryStats.minimumFreeBytes = freeBytes;
+  }
+}
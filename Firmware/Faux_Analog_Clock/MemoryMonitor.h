@@ -0,0 +1,40 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include "Arduino.h"
+
+/**
+ * The value painted over free SRAM at boot; the stack high-water mark is the lowest address no longer holding it
+ */
+const uint8_t MEMORY_PAINT_VALUE = 0xc5;
+
+/**
+ * SRAM usage, as of the last memoryMonitorUpdate() (dump the `memoryStats` symbol from a simulator such as simavr to read it off-device)
+ */
+struct MemoryStats {
+  uint16_t staticBytes;    // .data, .bss and .noinit
+  uint16_t heapBytes;      // The heap's high-water mark (the heap never shrinks below its break)
+  uint16_t stackBytes;     // The stack's high-water mark
+  uint16_t minimumFreeBytes; // The smallest gap seen between the heap and the stack (0xFFFF until the first update)
+};
+
+extern MemoryStats memoryStats;
+
+/**
+ * Measures the heap and scans for the stack high-water mark.
+ * The scan only covers the painted gap between the heap and the stack, so it gets cheaper as the stack's high-water mark deepens.
+ */
+void memoryMonitorUpdate();
+
+/**
+ * Measures the given memory layout into memoryStats (memoryMonitorUpdate() passes the AVR's own; host tests pass theirs)
+ *
+ * @param dataStart The start of the static data
+ * @param heapStart The start of the heap (the end of the static data)
+ * @param heapEnd The end of the heap
+ * @param stackPointer The stack pointer (the next byte the stack will use)
+ * @param ramEnd The last byte of SRAM
+ */
+void memoryMonitorMeasure(const uint8_t *dataStart, const uint8_t *heapStart, const uint8_t *heapEnd, const uint8_t *stackPointer, const uint8_t *ramEnd);
+
+#endif
@@ -1,11 +1,102 @@
 #include "Arduino.h"
 #include "SevenSegment.h"
+#include "ClockTime.h"
 
-void writeSevenSegmentDisplay(FrameBufferView *frameBuffer, char value, uint8_t brightness) {
-  uint8_t tableIndex = static_cast<uint8_t>(value & 0x7f);
-  uint8_t segments = pgm_read_byte(SEVEN_SEGMENT_ASCII_TABLE + tableIndex);
-  for (uint8_t i = 0; i < 7; ++i) {
-    frameBuffer->setValue(i, ((segments & 0x1) > 0) ? brightness : 0);
-    segments >>= 1;
+SevenSegmentText::SevenSegmentText(FrameBufferView *leftBuffer, FrameBufferView *rightBuffer) {
+  buffers[0] = leftBuffer;
+  buffers[1] = rightBuffer;
+  scrollText = NULL;
+  scrollTextInRAM = false;
+  scrollLength = 0;
+  scrollPosition = 0;
+  lastScrollStepMillis = 0;
+  invalidate();
+}
+
+void SevenSegmentText::setText(char left, char right, uint8_t brightness) {
+  scrollText = NULL;
+  writeDigit(0, left, brightness);
+  writeDigit(1, right, brightness);
+  this->brightness = brightness;
+  invalidated = false;
+}
+
+void SevenSegmentText::setScrollingText(const char *text, uint8_t brightness) {
+  startScrolling(text, false, brightness);
+}
+
+void SevenSegmentText::setScrollingRAMText(const char *text, uint8_t brightness) {
+  startScrolling(text, true, brightness);
+}
+
+void SevenSegmentText::startScrolling(const char *text, bool inRAM, uint8_t brightness) {
+  if (text != scrollText || inRAM != scrollTextInRAM) {
+    scrollText = text;
+    scrollTextInRAM = inRAM;
+    scrollPosition = 0;
+    lastScrollStepMillis = clockMillis();
+  } else if (brightness == this->brightness && !invalidated) {
+    update();
+    return;
+  }
+  writeScrollStep(brightness);
+}
+
+void SevenSegmentText::update() {
+  if (scrollText != NULL) {
+    uint32_t currentMillis = clockMillis();
+    if (currentMillis - lastScrollStepMillis >= SEVEN_SEGMENT_SCROLL_STEP_MS) {
+      lastScrollStepMillis = currentMillis;
+
+      // Positions 0..SEVEN_SEGMENT_SCROLL_HOLD_STEPS hold the start, then the text scrolls until both digits are blank
+      if (++scrollPosition > scrollLength + SEVEN_SEGMENT_SCROLL_HOLD_STEPS) {
+        scrollPosition = 0;
+      }
+      writeScrollStep(brightness);
+    }
+  }
+}
+
+void SevenSegmentText::invalidate() {
+  characters[0] = characters[1] = 0;
+  segments[0] = segments[1] = 0;
+  brightness = 0;
+  invalidated = true;
+}
+
+void SevenSegmentText::writeDigit(uint8_t digit, char value, uint8_t brightness) {
+  bool sameBrightness = brightness == this->brightness && !invalidated;
+  if (value == characters[digit] && sameBrightness) {
+    return;
+  }
+
+  uint8_t newSegments = pgm_read_byte(SEVEN_SEGMENT_ASCII_TABLE + static_cast<uint8_t>(value & 0x7f));
+  uint8_t changedSegments = sameBrightness ? newSegments ^ segments[digit] : 0x7f;
+  characters[digit] = value;
+  segments[digit] = newSegments;
+
+  FrameBufferView *buffer = buffers[digit];
+  for (uint8_t i = 0; changedSegments != 0; ++i) {
+    if ((changedSegments & 0x1) > 0) {
+      buffer->setValue(i, ((newSegments & 0x1) > 0) ? brightness : 0);
+    }
+    changedSegments >>= 1;
+    newSegments >>= 1;
+  }
+}
+
+void SevenSegmentText::writeScrollStep(uint8_t brightness) {
+  size_t length = scrollTextInRAM ? strlen(scrollText) : strlen_P(scrollText);
+  scrollLength = static_cast<uint8_t>(min(length, static_cast<size_t>(255 - SEVEN_SEGMENT_SCROLL_HOLD_STEPS)));
+  uint8_t offset = scrollPosition > SEVEN_SEGMENT_SCROLL_HOLD_STEPS ? scrollPosition - SEVEN_SEGMENT_SCROLL_HOLD_STEPS : 0;
+  for (uint8_t digit = 0; digit < 2; ++digit) {
+    uint8_t index = offset + digit;
+    char value = ' ';
+    if (index < scrollLength) {
+      value = scrollTextInRAM ? scrollText[index] : pgm_read_byte(scrollText + index);
+    }
+    writeDigit(digit, value, brightness);
   }
+  this->brightness = brightness;
+  invalidated = false;
 }
@@ -34,12 +34,95 @@ const PROGMEM uint8_t SEVEN_SEGMENT_ASCII_TABLE[] = {
 // 0GFEDCBA
 
 /**
- * Writes the given ASCII character to the given 7-segment display buffer
- * 
- * @param frameBuffer The buffer to write to
- * @param value The character to write
- * @param brightness The display brightness of the character
+ * The number of milliseconds each step of scrolling text is shown
  */
-void writeSevenSegmentDisplay(FrameBufferView *frameBuffer, char value, uint8_t brightness);
+const uint16_t SEVEN_SEGMENT_SCROLL_STEP_MS = 350;
+
+/**
+ * The number of extra steps for which the start of scrolling text is held before it scrolls
+ */
+const uint8_t SEVEN_SEGMENT_SCROLL_HOLD_STEPS = 3;
+
+/**
+ * Renders text onto a pair of 7-segment displays.
+ * The last character and brightness shown on each digit are cached, so setting unchanged text costs nothing and changed
+ * text only rewrites the segments which differ. Text longer than two characters scrolls across both digits on a timer.
+ * The display buffers must not be written by anything else (or invalidate() must be called afterwards).
+ */
+class SevenSegmentText {
+public:
+  /**
+   * Creates a text renderer for the given pair of 7-segment display buffers
+   * 
+   * @param leftBuffer The left digit's buffer
+   * @param rightBuffer The right digit's buffer
+   */
+  SevenSegmentText(FrameBufferView *leftBuffer, FrameBufferView *rightBuffer);
+
+  /**
+   * Shows two characters (stopping any scrolling text)
+   * 
+   * @param left The character for the left digit
+   * @param right The character for the right digit
+   * @param brightness The display brightness of the text
+   */
+  void setText(char left, char right, uint8_t brightness);
+
+  /**
+   * Scrolls the given text across both digits, repeating: the first two characters are shown first, then the text moves
+   * left one character every SEVEN_SEGMENT_SCROLL_STEP_MS until it has left the display.
+   * Setting the text which is already scrolling only updates its brightness.
+   * 
+   * @param text The text to scroll (a PROGMEM string, which must stay valid while scrolling)
+   * @param brightness The display brightness of the text
+   */
+  void setScrollingText(const char *text, uint8_t brightness);
+
+  /**
+   * Scrolls text from SRAM, like setScrollingText(); the text may change while it scrolls (e.g. a live statistic)
+   * 
+   * @param text The text to scroll (which must stay valid while scrolling)
+   * @param brightness The display brightness of the text
+   */
+  void setScrollingRAMText(const char *text, uint8_t brightness);
+
+  /**
+   * Advances scrolling text (call regularly; does nothing for two characters of text)
+   */
+  void update();
+
+  /**
+   * Forces every segment to be written again (e.g. after something else wrote to the display buffers)
+   */
+  void invalidate();
+
+private:
+  FrameBufferView *buffers[2];
+  char characters[2];
+  uint8_t segments[2];
+  uint8_t brightness;
+  bool invalidated;
+
+  const char *scrollText;
+  bool scrollTextInRAM;
+  uint8_t scrollLength;
+  uint8_t scrollPosition;
+  uint32_t lastScrollStepMillis;
+
+  /**
+   * Shows a character on one digit, writing only the segments which changed
+   */
+  void writeDigit(uint8_t digit, char value, uint8_t brightness);
+
+  /**
+   * Starts scrolling the given text, or keeps scrolling it if it already is
+   */
+  void startScrolling(const char *text, bool inRAM, uint8_t brightness);
+
+  /**
+   * Shows the current step of the scrolling text
+   */
+  void writeScrollStep(uint8_t brightness);
+};
 
 #endif
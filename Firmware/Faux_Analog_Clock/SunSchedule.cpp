@@ -0,0 +1,183 @@
+#include "Arduino.h"
+#include <RTClib.h>
+#include "ClockFace.h"
+#include "FixedMath.h"
+#include "SunSchedule.h"
+
+/*
+ * All solar math is done in fixed point (see FixedMath.h)
+ */
+
+const int16_t MINUTES_PER_DAY = 1440;
+const uint16_t NO_CACHED_MINUTE = 0xffff;
+
+const int16_t SUN_MAX_DECLINATION = 4267; // 23.44 degrees
+const int16_t SUN_HORIZON_SINE = -238;    // sin(-0.833 degrees) (atmospheric refraction + the radius of the sun)
+
+const PROGMEM uint16_t DAYS_BEFORE_MONTH[] = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+/**
+ * Wraps the given number of minutes into a single day
+ */
+static uint16_t wrapMinutes(int16_t minutes) {
+  while (minutes < 0) {
+    minutes += MINUTES_PER_DAY;
+  }
+  while (minutes >= MINUTES_PER_DAY) {
+    minutes -= MINUTES_PER_DAY;
+  }
+  return static_cast<uint16_t>(minutes);
+}
+
+/**
+ * Gets the inner face ring twilight brightness for the given minute with respect to a sunrise/sunset
+ */
+static uint8_t getTwilightBrightness(uint16_t minuteOfDay, uint16_t eventMinute) {
+  uint16_t offset = wrapMinutes(static_cast<int16_t>(minuteOfDay) - static_cast<int16_t>(eventMinute) + FACE_TWILIGHT_MINUTES);
+  if (offset > 2 * FACE_TWILIGHT_MINUTES) {
+    return 0;
+  }
+  return pgm_read_byte(FaceTwilightGradient::values + offset / FACE_TWILIGHT_STEP_MINUTES);
+}
+
+
+SunSchedule::SunSchedule() {
+  latitude = 0;
+  longitude = 0;
+  locationValid = false;
+  utcOffsetHours = 0;
+
+  scheduleDirty = true;
+  scheduleDay = 0;
+  sunriseMinute = FACE_DEFAULT_SUNRISE_MINUTE;
+  sunsetMinute = FACE_DEFAULT_SUNSET_MINUTE;
+  dayStartMinute = FACE_DEFAULT_SUNRISE_MINUTE - FACE_TWILIGHT_MINUTES;
+  dayLengthMinutes = FACE_DEFAULT_SUNSET_MINUTE - dayStartMinute;
+  sunCrossesHorizon = true;
+
+  cachedMinute = NO_CACHED_MINUTE;
+  faceInnerBrightness = 0;
+  night = false;
+}
+
+void SunSchedule::setLocation(int16_t latitude, int16_t longitude) {
+  if (!locationValid || latitude != this->latitude || longitude != this->longitude) {
+    this->latitude = latitude;
+    this->longitude = longitude;
+    locationValid = true;
+    scheduleDirty = true;
+  }
+}
+
+void SunSchedule::setTimeZone(int8_t timezone, bool dst) {
+  int8_t offset = timezone + (dst ? 1 : 0);
+  if (offset != utcOffsetHours) {
+    utcOffsetHours = offset;
+    scheduleDirty = true;
+  }
+}
+
+void SunSchedule::update(const DateTime &now) {
+  if (scheduleDirty || now.day() != scheduleDay) {
+    computeSchedule(now);
+    cachedMinute = NO_CACHED_MINUTE;
+  }
+
+  uint16_t minuteOfDay = static_cast<uint16_t>(now.hour()) * 60 + now.minute();
+  if (minuteOfDay != cachedMinute) {
+    updateCachedMinute(minuteOfDay);
+  }
+}
+
+bool SunSchedule::isNight() const {
+  return night;
+}
+
+uint8_t SunSchedule::getFaceInnerBrightness() const {
+  return faceInnerBrightness;
+}
+
+uint8_t SunSchedule::getFaceOuterBrightness() const {
+  return 255 - faceInnerBrightness;
+}
+
+uint16_t SunSchedule::getSunriseMinute() const {
+  return sunriseMinute;
+}
+
+uint16_t SunSchedule::getSunsetMinute() const {
+  return sunsetMinute;
+}
+
+
+void SunSchedule::computeSchedule(const DateTime &now) {
+  scheduleDirty = false;
+  scheduleDay = now.day();
+
+  if (!locationValid) {
+    // No GPS position yet; fall back to the default schedule
+    sunriseMinute = FACE_DEFAULT_SUNRISE_MINUTE;
+    sunsetMinute = FACE_DEFAULT_SUNSET_MINUTE;
+    dayStartMinute = FACE_DEFAULT_SUNRISE_MINUTE - FACE_TWILIGHT_MINUTES;
+    dayLengthMinutes = FACE_DEFAULT_SUNSET_MINUTE - dayStartMinute;
+    sunCrossesHorizon = true;
+    return;
+  }
+
+  // Day of the year (0-based)
+  uint16_t dayOfYear = pgm_read_word(DAYS_BEFORE_MONTH + now.month() - 1) + now.day() - 1;
+  if (now.month() > 2 && (now.year() & 3) == 0) {
+    ++dayOfYear;
+  }
+
+  // Solar declination: -23.44 degrees * cos(360 / 365 * (day + 10))
+  uint16_t declinationDayAngle = static_cast<uint16_t>((static_cast<uint32_t>(dayOfYear + 10) << 16) / 365);
+  uint16_t declination = static_cast<uint16_t>(-((static_cast<int32_t>(SUN_MAX_DECLINATION) * fixedCos(declinationDayAngle)) >> 14));
+
+  // Equation of time, in tenths of a minute: 9.87 * sin(2B) - 7.53 * cos(B) - 1.5 * sin(B), where B = 360 / 365 * (day - 81)
+  uint16_t equationDayAngle = static_cast<uint16_t>((static_cast<uint32_t>(dayOfYear + 365 - 81) << 16) / 365);
+  int16_t equationOfTime = static_cast<int16_t>((99L * fixedSin(equationDayAngle << 1) - 75L * fixedCos(equationDayAngle) - 15L * fixedSin(equationDayAngle)) >> 14);
+
+  // Sunrise hour angle: cos(w) = (sin(horizon) - sin(lat) * sin(decl)) / (cos(lat) * cos(decl))
+  uint16_t latitudeAngle = static_cast<uint16_t>(static_cast<int32_t>(latitude) * 2048 / 1125);
+  int32_t numerator = static_cast<int32_t>(SUN_HORIZON_SINE) * 16384 - static_cast<int32_t>(fixedSin(latitudeAngle)) * fixedSin(declination);
+  int32_t denominator = (static_cast<int32_t>(fixedCos(latitudeAngle)) * fixedCos(declination)) >> 14;
+  int16_t hourAngleCosine;
+  if (denominator <= 0) {
+    hourAngleCosine = numerator < 0 ? -16384 : 16384;
+  } else {
+    hourAngleCosine = static_cast<int16_t>(constrain(numerator / denominator, -16384L, 16384L));
+  }
+
+  // 4 minutes of time per degree of hour angle (a full turn is one day)
+  int16_t hourAngleMinutes = static_cast<int16_t>((static_cast<uint32_t>(fixedAcos(hourAngleCosine)) * 45) >> 11);
+
+  // Local solar noon: 4 minutes per degree of longitude, corrected by the equation of time
+  int16_t solarNoonMinute = 720 - longitude / 25 - equationOfTime / 10 + static_cast<int16_t>(utcOffsetHours) * 60;
+
+  sunriseMinute = wrapMinutes(solarNoonMinute - hourAngleMinutes);
+  sunsetMinute = wrapMinutes(solarNoonMinute + hourAngleMinutes);
+  dayStartMinute = wrapMinutes(static_cast<int16_t>(sunriseMinute) - FACE_TWILIGHT_MINUTES);
+
+  // A clamped cosine means the sun stays below (polar night) or above (midnight sun) the horizon all day, with no twilight
+  sunCrossesHorizon = hourAngleCosine > -16384 && hourAngleCosine < 16384;
+  if (hourAngleCosine >= 16384) {
+    dayLengthMinutes = 0;
+  } else if (hourAngleCosine <= -16384) {
+    dayLengthMinutes = MINUTES_PER_DAY;
+  } else {
+    dayLengthMinutes = min(2 * hourAngleMinutes + FACE_TWILIGHT_MINUTES, MINUTES_PER_DAY);
+  }
+}
+
+void SunSchedule::updateCachedMinute(uint16_t minuteOfDay) {
+  cachedMinute = minuteOfDay;
+  night = wrapMinutes(static_cast<int16_t>(minuteOfDay) - static_cast<int16_t>(dayStartMinute)) >= dayLengthMinutes;
+  if (sunCrossesHorizon) {
+    faceInnerBrightness = max(getTwilightBrightness(minuteOfDay, sunriseMinute), getTwilightBrightness(minuteOfDay, sunsetMinute));
+  } else {
+    faceInnerBrightness = 0;
+  }
+}
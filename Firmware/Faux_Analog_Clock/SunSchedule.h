@@ -0,0 +1,93 @@
+#ifndef SUN_SCHEDULE_H
+#define SUN_SCHEDULE_H
+
+#include <RTClib.h>
+#include "Arduino.h"
+
+/**
+ * Computes local sunrise/sunset from the GPS position and derives the face ring twilight effects from them.
+ * The (fixed point) solar computation only runs once per day; the face ring values are cached per minute.
+ */
+class SunSchedule {
+public:
+  /**
+   * Creates a sun schedule which uses the default sunrise/sunset times until a location is set
+   */
+  SunSchedule();
+
+  /**
+   * Sets the position of the clock
+   *
+   * @param latitude The latitude, in hundredths of a degree (north is positive)
+   * @param longitude The longitude, in hundredths of a degree (east is positive)
+   */
+  void setLocation(int16_t latitude, int16_t longitude);
+
+  /**
+   * Sets the current timezone
+   *
+   * @param timezone The timezone offset, WRT GMT
+   * @param dst Whether DST is active or not
+   */
+  void setTimeZone(int8_t timezone, bool dst);
+
+  /**
+   * Updates the schedule for the given local time, recomputing sunrise/sunset if the day has changed
+   */
+  void update(const DateTime &now);
+
+  /**
+   * Returns true if it is currently night (from sunset until the start of the morning twilight)
+   */
+  bool isNight() const;
+
+  /**
+   * Gets the current inner face ring brightness (before multiplying by the clock brightness)
+   */
+  uint8_t getFaceInnerBrightness() const;
+
+  /**
+   * Gets the current outer face ring brightness (before multiplying by the clock brightness)
+   */
+  uint8_t getFaceOuterBrightness() const;
+
+  /**
+   * Gets today's sunrise, in minutes after local midnight
+   */
+  uint16_t getSunriseMinute() const;
+
+  /**
+   * Gets today's sunset, in minutes after local midnight
+   */
+  uint16_t getSunsetMinute() const;
+
+private:
+  int16_t latitude;
+  int16_t longitude;
+  bool locationValid;
+  int8_t utcOffsetHours;
+
+  bool scheduleDirty;
+  uint8_t scheduleDay;
+  uint16_t sunriseMinute;
+  uint16_t sunsetMinute;
+  uint16_t dayStartMinute;
+  uint16_t dayLengthMinutes;
+  bool sunCrossesHorizon; // False during polar night or midnight sun (no sunrise or sunset)
+
+  uint16_t cachedMinute;
+  uint8_t faceInnerBrightness;
+  bool night;
+
+  /**
+   * Computes sunrise/sunset for the given date
+   */
+  void computeSchedule(const DateTime &now);
+
+  /**
+   * Refreshes the cached face ring brightness and night flag for the given minute of the day
+   */
+  void updateCachedMinute(uint16_t minuteOfDay);
+};
+
+#endif
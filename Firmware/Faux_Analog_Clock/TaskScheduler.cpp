@@ -0,0 +1,101 @@
+#include "Arduino.h"
+#include "TaskScheduler.h"
+#include "ClockTime.h"
+#include "Trace.h"
+#include "Watchdog.h"
+
+TaskScheduler::TaskScheduler(const ScheduledTask *tasks, uint8_t taskCount) {
+  this->tasks = tasks;
+  this->taskCount = taskCount;
+  taskStates = new TaskState[taskCount];
+  resetStatistics();
+  for (uint8_t i = 0; i < taskCount; ++i) {
+    taskStates[i].releaseMillis = 0;
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  delete[] taskStates;
+}
+
+void TaskScheduler::begin() {
+  uint32_t currentMillis = clockMillis();
+  for (uint8_t i = 0; i < taskCount; ++i) {
+    taskStates[i].releaseMillis = currentMillis;
+  }
+}
+
+void TaskScheduler::runDueTasks() {
+  watchdogEnterPhase(WATCHDOG_PHASE_SCHEDULER, WATCHDOG_TASK_TIMEOUT);
+  for (uint8_t i = 0; i < taskCount; ++i) {
+    TaskState &state = taskStates[i];
+    if (static_cast<int32_t>(clockMillis() - state.releaseMillis) < 0) {
+      continue;
+    }
+
+    ScheduledTask task;
+    memcpy_P(&task, tasks + i, sizeof(ScheduledTask));
+
+    // A task which runs on every pass is released when it starts, so its deadline doesn't include the other tasks' runtime
+    if (task.periodMilliseconds == 0) {
+      state.releaseMillis = clockMillis();
+    }
+
+    // Run the task and measure it (under its own watchdog budget, so a stall is pinned on the task)
+    watchdogEnterPhase(WATCHDOG_PHASE_FIRST_TASK + i, WATCHDOG_TASK_TIMEOUT);
+    TRACE(TRACE_EVENT_TASK_BEGIN, i);
+    uint32_t startMicros = clockMicros();
+    task.run();
+    uint32_t elapsedMicros = clockMicros() - startMicros;
+    TRACE(TRACE_EVENT_TASK_END, i);
+    state.lastMicroseconds = static_cast<uint16_t>(min(elapsedMicros, 65535UL));
+    state.maxMicroseconds = max(state.maxMicroseconds, state.lastMicroseconds);
+
+    // Check the deadline
+    uint32_t finishMillis = clockMillis();
+    if (finishMillis - state.releaseMillis > task.deadlineMilliseconds) {
+      TRACE(TRACE_EVENT_DEADLINE_OVERRUN, i);
+      if (state.overrunCount < 65535) {
+        ++state.overrunCount;
+      }
+    }
+
+    // Schedule the next release (releases which have already been missed are skipped rather than run back to back)
+    state.releaseMillis += task.periodMilliseconds;
+    if (static_cast<int32_t>(finishMillis - state.releaseMillis) > 0) {
+      state.releaseMillis = finishMillis;
+    }
+  }
+}
+
+uint8_t TaskScheduler::getTaskCount() const {
+  return taskCount;
+}
+
+uint16_t TaskScheduler::getOverrunCount(uint8_t taskIndex) const {
+  return taskIndex < taskCount ? taskStates[taskIndex].overrunCount : 0;
+}
+
+uint16_t TaskScheduler::getTotalOverrunCount() const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < taskCount; ++i) {
+    total += taskStates[i].overrunCount;
+  }
+  return static_cast<uint16_t>(min(total, 65535UL));
+}
+
+uint16_t TaskScheduler::getLastExecutionMicroseconds(uint8_t taskIndex) const {
+  return taskIndex < taskCount ? taskStates[taskIndex].lastMicroseconds : 0;
+}
+
+uint16_t TaskScheduler::getMaxExecutionMicroseconds(uint8_t taskIndex) const {
+  return taskIndex < taskCount ? taskStates[taskIndex].maxMicroseconds : 0;
+}
+
+void TaskScheduler::resetStatistics() {
+  for (uint8_t i = 0; i < taskCount; ++i) {
+    taskStates[i].lastMicroseconds = 0;
+    taskStates[i].maxMicroseconds = 0;
+    taskStates[i].overrunCount = 0;
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "Arduino.h"
+
+/**
+ * A periodic task, as stored in a (PROGMEM) task table
+ */
+struct ScheduledTask {
+  // The function which runs the task
+  void (*run)();
+
+  // The number of milliseconds between task releases (0 runs the task on every pass)
+  uint16_t periodMilliseconds;
+
+  // The number of milliseconds after its release by which the task must have finished running
+  // (a task with no period is released when it starts, so this bounds its own execution time)
+  uint16_t deadlineMilliseconds;
+};
+
+/**
+ * Cooperative scheduler for a static table of periodic tasks.
+ * Tasks run to completion in table order (so earlier tasks take priority when several are due at once).
+ * The execution time of every task is measured, and a task which finishes after its deadline counts as an overrun.
+ * Every task also runs under WATCHDOG_TASK_TIMEOUT, so a task which hangs resets the clock (see Watchdog.h).
+ */
+class TaskScheduler {
+public:
+  /**
+   * @param tasks The task table (in PROGMEM)
+   * @param taskCount The number of tasks in the table
+   */
+  TaskScheduler(const ScheduledTask *tasks, uint8_t taskCount);
+
+  /**
+   * Deletes the task state
+   */
+  ~TaskScheduler();
+
+  /**
+   * Releases every task immediately
+   */
+  void begin();
+
+  /**
+   * Runs every task which is due, then returns
+   */
+  void runDueTasks();
+
+  /**
+   * Gets the number of tasks in the table
+   */
+  uint8_t getTaskCount() const;
+
+  /**
+   * Gets the number of times the given task finished after its deadline (saturates at 65535)
+   */
+  uint16_t getOverrunCount(uint8_t taskIndex) const;
+
+  /**
+   * Gets the number of deadline overruns of all tasks (saturates at 65535)
+   */
+  uint16_t getTotalOverrunCount() const;
+
+  /**
+   * Gets the execution time of the last run of the given task, in microseconds (saturates at 65535)
+   */
+  uint16_t getLastExecutionMicroseconds(uint8_t taskIndex) const;
+
+  /**
+   * Gets the longest execution time of the given task, in microseconds (saturates at 65535)
+   */
+  uint16_t getMaxExecutionMicroseconds(uint8_t taskIndex) const;
+
+  /**
+   * Clears the overrun counts and execution times of all tasks
+   */
+  void resetStatistics();
+
+private:
+  struct TaskState {
+    uint32_t releaseMillis;
+    uint16_t lastMicroseconds;
+    uint16_t maxMicroseconds;
+    uint16_t overrunCount;
+  };
+
+  const ScheduledTask *tasks;
+  uint8_t taskCount;
+  TaskState *taskStates;
+};
+
+#endif
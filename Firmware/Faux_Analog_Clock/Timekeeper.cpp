@@ -1,18 +1,51 @@
 #include "Arduino.h"
 #include "Timekeeper.h"
+#include "Trace.h"
+#include "InputReplay.h"
+#include "Watchdog.h"
 #include <RTClib.h>
 
-Timekeeper::Timekeeper(uint8_t gpsTX, uint8_t gpsRX, uint32_t timeSetIntervalSeconds) : gpsSerial(gpsTX, gpsRX), gps(&gpsSerial) {
+#ifdef CLOCK_VIRTUAL_TIME
+// Replay the captured GPS data rather than reading the serial port
+#define GPS_STREAM (&inputReplay)
+#else
+#define GPS_STREAM (&gpsSerial)
+#endif
+
+const uint16_t TIMEKEEPER_RESUME_MAGIC = 0x544b;
+
+/**
+ * What the timekeeper knew as of the last time the RTC was set
+ */
+struct TimekeeperResumeState {
+  uint16_t magic;
+  uint32_t lastSetTime;
+  int8_t timezone;
+  bool dst;
+  bool locationValid;
+  int16_t latitude;
+  int16_t longitude;
+};
+
+// Not cleared at startup, so the time set survives a watchdog reset
+static TimekeeperResumeState resumeState __attribute__((section(".noinit")));
+
+Timekeeper::Timekeeper(uint8_t gpsTX, uint8_t gpsRX, uint32_t timeSetIntervalSeconds) : gpsSerial(gpsTX, gpsRX), gps(GPS_STREAM) {
   this->timeSetIntervalSeconds = timeSetIntervalSeconds;
   lastTimeValid = false;
+  locationValid = false;
+  latitude = 0;
+  longitude = 0;
 }
 
-void Timekeeper::begin() {
+void Timekeeper::begin(bool resume) {
   // Init RTC
-#ifdef USE_HARDWARE_RTC
+#if defined(USE_HARDWARE_RTC) && !defined(CLOCK_VIRTUAL_TIME)
   rtc.begin();
+  rtc.readBlocking(lastTime);
 #else
   rtc.begin(DateTime(static_cast<uint32_t>(0)));
+  lastTime = rtc.now();
 #endif
 
   // Init GPS
@@ -20,7 +53,7 @@ void Timekeeper::begin() {
   setupGPS(false);
 
   // Init milliseconds
-  lastMillis = currentMillis = millis();
+  lastMillis = currentMillis = clockMillis();
   lastSetTime = 0;
   lastSetAttemptMillis = 0;
 
@@ -28,7 +61,10 @@ void Timekeeper::begin() {
   timezone = -6;
   dst = true;
   pendingTimezoneAdjustment = 0;
-  pendingTimeReset = true;
+  pendingTimeReset = !(resume && loadResumeState());
+  if (pendingTimeReset) {
+    resumeState.magic = 0;
+  }
 }
 
 
@@ -39,14 +75,23 @@ void Timekeeper::update() {
     setClockTime();
   }
 
-  // Update time
-  uint8_t lastSecond = lastTime.second();
-  lastTime = rtc.now();
-
   // Update milliseconds
-  uint32_t nowMillis = millis();
+  uint32_t nowMillis = clockMillis();
+  currentMillis = nowMillis;
+  if (!pendingTimeReset && lastTimeValid && (nowMillis - lastMillis < RTC_QUIET_MS)) {
+    return;
+  }
+
+  // Update time (only near the next second boundary, which is all that's needed to track it)
+  DateTime time;
+  uint32_t readMillis;
+  if (!readRTC(time, readMillis)) {
+    return;
+  }
+  uint8_t lastSecond = lastTime.second();
+  lastTime = time;
   if (lastTime.second() != lastSecond) {
-    lastMillis = nowMillis;
+    lastMillis = readMillis;
 
     // Apply pending timezone adjustment only just as seconds are changing
     if (pendingTimezoneAdjustment != 0) {
@@ -55,9 +100,9 @@ void Timekeeper::update() {
       rtc.adjust(lastTime);
       pendingTimezoneAdjustment = 0;
       lastSetTime = lastTime.unixtime();
+      saveResumeState();
     }
   }
-  currentMillis = nowMillis;
 
   lastTimeValid = lastTime.isValid();
 }
@@ -71,7 +116,7 @@ const DateTime &Timekeeper::getTime() const {
   return lastTime;
 }
 
-const uint16_t Timekeeper::getMilliseconds() const {
+uint16_t Timekeeper::getMilliseconds() const {
   return static_cast<uint16_t>(currentMillis - lastMillis) % 1000;
 }
 
@@ -89,6 +134,60 @@ bool Timekeeper::isTimeSetPending() {
   return pendingTimeReset;
 }
 
+bool Timekeeper::hasLocation() const {
+  return locationValid;
+}
+
+int16_t Timekeeper::getLatitude() const {
+  return latitude;
+}
+
+int16_t Timekeeper::getLongitude() const {
+  return longitude;
+}
+
+
+void Timekeeper::saveResumeState() {
+  resumeState.lastSetTime = lastSetTime;
+  resumeState.timezone = timezone;
+  resumeState.dst = dst;
+  resumeState.locationValid = locationValid;
+  resumeState.latitude = latitude;
+  resumeState.longitude = longitude;
+  resumeState.magic = TIMEKEEPER_RESUME_MAGIC;
+}
+
+bool Timekeeper::loadResumeState() {
+  if (resumeState.magic != TIMEKEEPER_RESUME_MAGIC || resumeState.lastSetTime == 0) {
+    return false;
+  }
+
+  // The RTC must still be running from the last time set (begin() has read it)
+  lastTimeValid = lastTime.isValid();
+  if (!lastTimeValid || lastTime.unixtime() < resumeState.lastSetTime) {
+    return false;
+  }
+
+  lastSetTime = resumeState.lastSetTime;
+  timezone = resumeState.timezone;
+  dst = resumeState.dst;
+  locationValid = resumeState.locationValid;
+  latitude = resumeState.latitude;
+  longitude = resumeState.longitude;
+  return true;
+}
+
+bool Timekeeper::readRTC(DateTime &time, uint32_t &readMillis) {
+#if defined(USE_HARDWARE_RTC) && !defined(CLOCK_VIRTUAL_TIME)
+  return rtc.read(time, readMillis);
+#else
+  TRACE(TRACE_EVENT_RTC_READ_BEGIN, 0);
+  time = rtc.now();
+  readMillis = clockMillis();
+  TRACE(TRACE_EVENT_RTC_READ_END, time.second());
+  return true;
+#endif
+}
 
 void Timekeeper::readGPS() {
   while (gps.available()) {
@@ -107,6 +206,7 @@ void Timekeeper::setClockTime() {
 
   // Set the time
   if (gps.newNMEAreceived()) {
+    TRACE(TRACE_EVENT_NMEA_RECEIVED, 0);
     if (gps.parse(gps.lastNMEA())) {
       if (gps.fix && gps.year > 0) {
         TimeSpan timezoneOffset(0, timezone + (dst ? 1 : 0), 0, 0);
@@ -117,6 +217,19 @@ void Timekeeper::setClockTime() {
   
         lastSetTime = lastTime.unixtime();
         pendingTimeReset = false;
+        TRACE(TRACE_EVENT_GPS_TIME_SET, gps.seconds);
+
+        // Capture the position for sunrise/sunset computation (the GPS reports degrees * 10^7, with the hemisphere given separately)
+        latitude = static_cast<int16_t>(labs(gps.latitude_fixed) / 100000L);
+        longitude = static_cast<int16_t>(labs(gps.longitude_fixed) / 100000L);
+        if (gps.lat == 'S') {
+          latitude = -latitude;
+        }
+        if (gps.lon == 'W') {
+          longitude = -longitude;
+        }
+        locationValid = true;
+        saveResumeState();
   
         // Stop the GPS serial port from listening.
         // I wish there were a better way than this, but SoftwareSerial does not provide an end() method.
@@ -133,10 +246,13 @@ void Timekeeper::setClockTime() {
 
 void Timekeeper::setupGPS(bool forceReset) {
   if (forceReset) {
+    TRACE(TRACE_EVENT_GPS_RESET, 0);
+    watchdogEnterPhase(WATCHDOG_PHASE_GPS_RESET, WATCHDOG_GPS_RESET_TIMEOUT);
     gps.sendCommand("$PMTK104*37\r\n");
-    delay(500);
+    clockDelay(500);
     readGPS();
-    delay(500);
+    clockDelay(500);
+    watchdogExitPhase();
   }
   gps.sendCommand(PMTK_SET_NMEA_OUTPUT_RMCGGA);
   gps.sendCommand(PMTK_SET_NMEA_UPDATE_100_MILLIHERTZ);
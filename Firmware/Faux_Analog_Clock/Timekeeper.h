@@ -4,13 +4,18 @@
 #include <RTClib.h>
 #include <Adafruit_GPS.h>
 #include <SoftwareSerial.h>
+#include "ClockTime.h"
+#include "DS1307.h"
 
-// Comment this out to use the software RTC
+// Comment this out to use the software RTC (the hardware RTC is a DS1307, read by an interrupt-driven driver)
 #define USE_HARDWARE_RTC 1
 
 // The number of milliseconds of failed time setting after which the GPS will be forcibly reset
 #define GPS_RESET_TIMEOUT_MS 900000
 
+// The number of milliseconds after a second boundary during which the RTC is not read (the second can't change yet)
+#define RTC_QUIET_MS 900
+
 class Timekeeper {
 public:
   /**
@@ -22,8 +27,11 @@ public:
 
   /**
    * Starts the RTC and GPS
+   * 
+   * @param resume If true (e.g. after a watchdog reset), the time, timezone and location from before the reset are
+   *               trusted (as long as the RTC kept running), rather than waiting for a GPS fix
    */
-  void begin();
+  void begin(bool resume);
 
   /**
    * Updates the RTC data, setting the RTC from the GPS if necessary
@@ -43,7 +51,7 @@ public:
   /**
    * Retrieves the number of milliseconds since the last second rollover
    */
-  const uint16_t getMilliseconds() const;
+  uint16_t getMilliseconds() const;
 
   /**
    * Sets the current timezone
@@ -63,9 +71,26 @@ public:
    */
   bool isTimeSetPending();
 
+  /**
+   * Returns true if the GPS has reported the clock's position
+   */
+  bool hasLocation() const;
+
+  /**
+   * Gets the latitude captured during the last GPS time set, in hundredths of a degree (north is positive)
+   */
+  int16_t getLatitude() const;
+
+  /**
+   * Gets the longitude captured during the last GPS time set, in hundredths of a degree (east is positive)
+   */
+  int16_t getLongitude() const;
+
 private:
-#ifdef USE_HARDWARE_RTC
-  RTC_DS1307 rtc;
+#if defined(CLOCK_VIRTUAL_TIME)
+  VirtualRTC rtc;
+#elif defined(USE_HARDWARE_RTC)
+  DS1307 rtc;
 #else
   RTC_Millis rtc;
 #endif
@@ -87,6 +112,30 @@ private:
   uint32_t lastSetTime;
   uint32_t lastSetAttemptMillis;
 
+  bool locationValid;
+  int16_t latitude;
+  int16_t longitude;
+
+
+  /**
+   * Saves the state needed to resume after a reset (call whenever the RTC is set)
+   */
+  void saveResumeState();
+
+  /**
+   * Restores the state saved before a reset, returning false if there is none (or the RTC didn't keep running)
+   */
+  bool loadResumeState();
+
+  /**
+   * Gets the time from the RTC if a new reading is ready (the hardware RTC is read in the background, a reading
+   * behind the time it's taken; software RTCs are read at once)
+   * 
+   * @param time Set to the time read
+   * @param readMillis Set to the clockMillis() at which the time was read
+   * @return True if a new time was read
+   */
+  bool readRTC(DateTime &time, uint32_t &readMillis);
 
   /**
    * Reads GPS data
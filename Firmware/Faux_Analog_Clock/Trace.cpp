@@ -0,0 +1,88 @@
+#include "Arduino.h"
+#include <util/atomic.h>
+#include "Trace.h"
+#include "ClockTime.h"
+
+#ifdef USE_TRACE
+
+// Not cleared at startup, so the events leading up to a reset can still be read afterwards
+TraceLog traceLog __attribute__((section(".noinit")));
+static bool traceFrozen = false;
+
+#ifdef CLOCK_VIRTUAL_TIME
+static void (*traceHook)(uint8_t id, uint8_t payload) = NULL;
+
+void traceSetHook(void (*hook)(uint8_t id, uint8_t payload)) {
+  traceHook = hook;
+}
+#endif
+
+void traceBegin() {
+  if (traceLog.magic != TRACE_MAGIC || traceLog.head >= TRACE_LOG_LENGTH || traceLog.count > TRACE_LOG_LENGTH) {
+    traceLog.magic = TRACE_MAGIC;
+    traceLog.head = 0;
+    traceLog.count = 0;
+  }
+  traceFrozen = false;
+  traceEvent(TRACE_EVENT_RESET, 0);
+}
+
+void traceEvent(uint8_t id, uint8_t payload) {
+  if (traceFrozen) {
+    return;
+  }
+#ifdef CLOCK_VIRTUAL_TIME
+  if (traceHook != NULL) {
+    traceHook(id, payload);
+  }
+#endif
+  uint16_t timestamp = static_cast<uint16_t>(clockMicros() >> 4);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    TraceEvent &event = traceLog.events[traceLog.head];
+    event.timestamp = timestamp;
+    event.id = id;
+    event.payload = payload;
+    traceLog.head = (traceLog.head + 1) & (TRACE_LOG_LENGTH - 1);
+    if (traceLog.count < TRACE_LOG_LENGTH) {
+      ++traceLog.count;
+    }
+  }
+}
+
+void traceSetFrozen(bool frozen) {
+  traceFrozen = frozen;
+}
+
+uint8_t traceGetLogSize() {
+  return sizeof(TraceLog);
+}
+
+uint8_t traceGetLogByte(uint8_t index) {
+  return index < sizeof(TraceLog) ? reinterpret_cast<const uint8_t *>(&traceLog)[index] : 0;
+}
+
+#else
+
+void traceBegin() {
+}
+
+#ifdef CLOCK_VIRTUAL_TIME
+void traceSetHook(void (*hook)(uint8_t id, uint8_t payload)) {
+}
+#endif
+
+void traceEvent(uint8_t id, uint8_t payload) {
+}
+
+void traceSetFrozen(bool frozen) {
+}
+
+uint8_t traceGetLogSize() {
+  return 0;
+}
+
+uint8_t traceGetLogByte(uint8_t index) {
+  return 0;
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Arduino.h"
+
+// Uncomment this to record an event trace (costs TRACE_LOG_LENGTH * 4 + 4 bytes of SRAM)
+//#define USE_TRACE 1
+
+/**
+ * The number of events kept in the trace log (must be a power of 2)
+ */
+const uint8_t TRACE_LOG_LENGTH = 32;
+
+/**
+ * The value identifying a valid trace log (the log is kept across resets)
+ */
+const uint16_t TRACE_MAGIC = 0x7ace;
+
+/**
+ * Trace event IDs (Tools/decode_trace.py reads these names from this file)
+ */
+const uint8_t TRACE_EVENT_RESET = 1;                 // Payload: 0
+const uint8_t TRACE_EVENT_TASK_BEGIN = 2;            // Payload: task index
+const uint8_t TRACE_EVENT_TASK_END = 3;              // Payload: task index
+const uint8_t TRACE_EVENT_DEADLINE_OVERRUN = 4;      // Payload: task index
+const uint8_t TRACE_EVENT_RTC_READ_BEGIN = 5;        // Payload: 0
+const uint8_t TRACE_EVENT_RTC_READ_END = 6;          // Payload: the second read
+const uint8_t TRACE_EVENT_GPS_TIME_SET = 7;          // Payload: the second received
+const uint8_t TRACE_EVENT_GPS_RESET = 8;             // Payload: 0
+const uint8_t TRACE_EVENT_OPTIONS_SAVE_BEGIN = 9;    // Payload: 0
+const uint8_t TRACE_EVENT_OPTIONS_SAVE_END = 10;     // Payload: 0
+const uint8_t TRACE_EVENT_OPTIONS_UPDATE_BEGIN = 11; // Payload: 0
+const uint8_t TRACE_EVENT_OPTIONS_UPDATE_END = 12;   // Payload: 0
+const uint8_t TRACE_EVENT_BUTTON_CHANGE = 13;        // Payload: bit 0 = Select pressed, bit 1 = Enter pressed
+const uint8_t TRACE_EVENT_NMEA_RECEIVED = 14;        // Payload: 0
+const uint8_t TRACE_EVENT_FRAME_SWAP = 15;           // Payload: 0
+const uint8_t TRACE_EVENT_REPLAY_BUTTONS = 16;      // Payload: the replayed button port state (virtual time builds only)
+const uint8_t TRACE_EVENT_REPLAY_GPS = 17;          // Payload: the replayed byte count (virtual time builds only)
+const uint8_t TRACE_EVENT_WATCHDOG_STALL = 18;     // Payload: the stalled watchdog phase (see Watchdog.h)
+
+/**
+ * A trace event (4 bytes)
+ */
+struct TraceEvent {
+  // clockMicros() / 16, so it wraps every 1.05 seconds
+  uint16_t timestamp;
+  uint8_t id;
+  uint8_t payload;
+};
+
+/**
+ * The trace log, a ring buffer of the most recent events.
+ * In memory (and in a readout): magic (2 bytes, little endian), index of the next event to write, number of events, events.
+ */
+struct TraceLog {
+  uint16_t magic;
+  uint8_t head;
+  uint8_t count;
+  TraceEvent events[TRACE_LOG_LENGTH];
+};
+
+#ifdef USE_TRACE
+#define TRACE(id, payload) traceEvent((id), (payload))
+#else
+#define TRACE(id, payload) ((void)0)
+#endif
+
+/**
+ * Starts tracing, keeping the events recorded before a reset if the log is still valid
+ */
+void traceBegin();
+
+/**
+ * Records an event (use TRACE() instead, so it compiles out when tracing is disabled)
+ */
+void traceEvent(uint8_t id, uint8_t payload);
+
+#ifdef CLOCK_VIRTUAL_TIME
+/**
+ * Sets a function which is called with every event as it's recorded (so a host harness can keep the whole trace)
+ */
+void traceSetHook(void (*hook)(uint8_t id, uint8_t payload));
+#endif
+
+/**
+ * Stops (or resumes) recording events, so the log can be read out without it changing
+ */
+void traceSetFrozen(bool frozen);
+
+/**
+ * Gets the size of the trace log in bytes (0 if tracing is disabled)
+ */
+uint8_t traceGetLogSize();
+
+/**
+ * Gets a byte of the trace log, in memory order
+ */
+uint8_t traceGetLogByte(uint8_t index);
+
+#endif
@@ -0,0 +1,143 @@
+#include "Arduino.h"
+#include <avr/wdt.h>
+#include <util/atomic.h>
+#include "Watchdog.h"
+#include "ClockTime.h"
+#include "Trace.h"
+
+const uint16_t WATCHDOG_LOG_MAGIC = 0x5744;
+
+// Not cleared at startup, so the watchdog interrupt can leave a record for after the reset
+WatchdogLog watchdogLog __attribute__((section(".noinit")));
+
+static volatile uint8_t currentPhase = WATCHDOG_PHASE_NONE;
+static volatile uint32_t phaseStartMillis = 0;
+static volatile uint8_t graceCount = 0;
+static uint8_t currentTimeout = 0xff;
+static uint8_t previousPhase = WATCHDOG_PHASE_NONE;
+static uint8_t previousTimeout = WATCHDOG_TASK_TIMEOUT;
+static bool stallReset = false;
+
+/**
+ * Gets the number of milliseconds the current phase has been running for (capped at 65535)
+ */
+static uint16_t getPhaseMillis() {
+  return static_cast<uint16_t>(min(clockMillis() - phaseStartMillis, 65535UL));
+}
+
+/**
+ * Records a stall which finished within its grace period (call with interrupts disabled)
+ */
+static void endStall() {
+  if (watchdogLog.stallCount < 255) {
+    ++watchdogLog.stallCount;
+  }
+  uint16_t stallMillis = getPhaseMillis();
+  if (stallMillis >= watchdogLog.longestStallMillis) {
+    watchdogLog.longestStallPhase = currentPhase;
+    watchdogLog.longestStallMillis = stallMillis;
+  }
+  graceCount = 0;
+}
+
+#ifndef CLOCK_VIRTUAL_TIME
+
+/**
+ * Turns off the watchdog before any constructor runs (it stays on, with its shortest timeout, after a watchdog reset)
+ */
+extern "C" void watchdogDisableAtBoot() __attribute__((naked, used, section(".init3")));
+void watchdogDisableAtBoot() {
+  MCUSR = 0;
+  wdt_disable();
+}
+
+/**
+ * Switches the watchdog to interrupt-then-reset mode with the given timeout
+ */
+static void configureWatchdog(uint8_t timeout) {
+  uint8_t value = _BV(WDIE) | _BV(WDE) | ((timeout & 0x08) != 0 ? _BV(WDP3) : 0) | (timeout & 0x07);
+
+  // The second write must follow the change enable within four cycles
+  __asm__ __volatile__ (
+    "sts %0, %1\n\t"
+    "sts %0, %2\n\t"
+    : : "n" (_SFR_MEM_ADDR(WDTCSR)), "r" (static_cast<uint8_t>(_BV(WDCE) | _BV(WDE))), "r" (value) : "memory");
+}
+
+/**
+ * Runs when a phase overruns its budget: the phase gets WATCHDOG_STALL_GRACE_TIMEOUTS more budgets, then the stall is
+ * recorded and the clock is reset
+ */
+ISR(WDT_vect) {
+  if (graceCount == 0) {
+    TRACE(TRACE_EVENT_WATCHDOG_STALL, currentPhase);
+  }
+  if (graceCount < WATCHDOG_STALL_GRACE_TIMEOUTS) {
+    ++graceCount;
+    WDTCSR |= _BV(WDIE); // The interrupt clears itself, and would leave the next timeout to reset the clock
+    return;
+  }
+
+  watchdogLog.resetPhase = currentPhase;
+  watchdogLog.resetStallMillis = getPhaseMillis();
+  if (watchdogLog.resetCount < 255) {
+    ++watchdogLog.resetCount;
+  }
+  watchdogLog.resetPending = true;
+  wdt_enable(WDTO_15MS);
+  while (true) {
+  }
+}
+
+#else
+
+static void configureWatchdog(uint8_t /* timeout */) {
+  // A host build has no watchdog
+}
+
+#endif
+
+void watchdogBegin() {
+  stallReset = watchdogLog.magic == WATCHDOG_LOG_MAGIC && watchdogLog.resetPending;
+  if (watchdogLog.magic != WATCHDOG_LOG_MAGIC) {
+    memset(&watchdogLog, 0, sizeof(WatchdogLog));
+    watchdogLog.magic = WATCHDOG_LOG_MAGIC;
+  }
+  watchdogLog.resetPending = false;
+  watchdogEnterPhase(WATCHDOG_PHASE_SETUP, WATCHDOG_SETUP_TIMEOUT);
+}
+
+bool watchdogWasStallReset() {
+  return stallReset;
+}
+
+void watchdogEnterPhase(uint8_t phase, uint8_t timeout) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (graceCount > 0) {
+      endStall();
+    }
+    previousPhase = currentPhase;
+    previousTimeout = currentTimeout;
+    currentPhase = phase;
+    phaseStartMillis = clockMillis();
+    wdt_reset();
+    if (timeout != currentTimeout) {
+      currentTimeout = timeout;
+      configureWatchdog(timeout);
+    }
+  }
+}
+
+void watchdogExitPhase() {
+  watchdogEnterPhase(previousPhase, previousTimeout);
+}
+
+void watchdogReset() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (graceCount > 0) {
+      endStall();
+    }
+    phaseStartMillis = clockMillis();
+    wdt_reset();
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "Arduino.h"
+#include <avr/wdt.h>
+
+/*
+ * Watchdog phases: what the clock was doing when it stalled
+ */
+const uint8_t WATCHDOG_PHASE_NONE = 0;
+const uint8_t WATCHDOG_PHASE_SETUP = 1;      // setup(), up until the scheduler starts
+const uint8_t WATCHDOG_PHASE_SCHEDULER = 2;  // Between tasks
+const uint8_t WATCHDOG_PHASE_GPS_RESET = 3;  // The GPS reset in Timekeeper::setupGPS()
+const uint8_t WATCHDOG_PHASE_FIRST_TASK = 8; // Scheduled task N is phase WATCHDOG_PHASE_FIRST_TASK + N
+
+/*
+ * Phase budgets (WDTO_* values)
+ */
+const uint8_t WATCHDOG_SETUP_TIMEOUT = WDTO_8S;     // Covers the RTC and GPS startup
+const uint8_t WATCHDOG_GPS_RESET_TIMEOUT = WDTO_2S; // The GPS reset waits one second
+const uint8_t WATCHDOG_TASK_TIMEOUT = WDTO_250MS;
+
+/**
+ * The number of extra budgets a stalled phase gets to finish before the watchdog resets the clock.
+ * Stalls which finish within them are only recorded.
+ */
+const uint8_t WATCHDOG_STALL_GRACE_TIMEOUTS = 3;
+
+/**
+ * The stall record, kept in .noinit so it survives the reset (it's only cleared at power on)
+ */
+struct WatchdogLog {
+  uint16_t magic;
+  bool resetPending;            // Set by the watchdog interrupt just before it resets the clock
+  uint8_t resetCount;           // Resets caused by stalls
+  uint8_t resetPhase;           // The phase which stalled before the last reset
+  uint16_t resetStallMillis;    // How long it had stalled for
+  uint8_t stallCount;           // Stalls which finished within their grace period
+  uint8_t longestStallPhase;    // The phase of the longest of those stalls
+  uint16_t longestStallMillis;  // How long it stalled for
+};
+
+extern WatchdogLog watchdogLog;
+
+/**
+ * Starts the watchdog in the setup phase (call first thing in setup())
+ */
+void watchdogBegin();
+
+/**
+ * Returns true if the clock was last reset by the watchdog
+ */
+bool watchdogWasStallReset();
+
+/**
+ * Enters a new phase, restarting the watchdog with the phase's budget
+ *
+ * @param phase The phase (see WATCHDOG_PHASE_*)
+ * @param timeout The phase's budget (a WDTO_* value)
+ */
+void watchdogEnterPhase(uint8_t phase, uint8_t timeout);
+
+/**
+ * Returns to the phase which was current before the last watchdogEnterPhase() (phases only nest one deep)
+ */
+void watchdogExitPhase();
+
+/**
+ * Restarts the current phase's budget (for phases which loop)
+ */
+void watchdogReset();
+
+#endif
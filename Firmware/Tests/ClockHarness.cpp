@@ -0,0 +1,61 @@
+#include "ClockHarness.h"
+#include "InputReplay.h"
+#include <stdio.h>
+#include <vector>
+
+static std::vector<uint8_t> capture;
+static int failedCheckCount = 0;
+
+bool startClock(const char *capturePath) {
+  FILE *file = fopen(capturePath, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Can't open %s\n", capturePath);
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    capture.insert(capture.end(), buffer, buffer + count);
+  }
+  fclose(file);
+
+  if (!inputReplay.begin(capture.data(), capture.size())) {
+    fprintf(stderr, "%s is not an input capture\n", capturePath);
+    return false;
+  }
+  setup();
+  return true;
+}
+
+void runClockUntil(uint64_t microseconds) {
+  while (getClockTime() < microseconds) {
+    loop();
+    inputReplay.update();
+  }
+}
+
+bool dumpFrontBuffer(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Can't write %s\n", path);
+    return false;
+  }
+  bool written = fwrite(clockDisplay.getFrontBuffer(), 1, ClockDisplay::LED_COUNT, file) == ClockDisplay::LED_COUNT;
+  return fclose(file) == 0 && written;
+}
+
+void harnessCheck(bool condition, const char *text, const char *file, int line) {
+  if (!condition) {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+    ++failedCheckCount;
+  }
+}
+
+int finishTest(const char *name) {
+  if (failedCheckCount > 0) {
+    printf("%s: FAILED (%d checks)\n", name, failedCheckCount);
+    return 1;
+  }
+  printf("%s: passed\n", name);
+  return 0;
+}
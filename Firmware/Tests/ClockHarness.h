@@ -0,0 +1,57 @@
+#ifndef CLOCK_HARNESS_H
+#define CLOCK_HARNESS_H
+
+#include "Arduino.h"
+#include "ClockTime.h"
+#include "ClockDisplay.h"
+#include "ClockOptions.h"
+#include "Timekeeper.h"
+#include "TaskScheduler.h"
+
+/*
+ * Runs the sketch on the host, on virtual time (see ClockTime.h), with its inputs replayed from a capture (see InputReplay.h)
+ */
+
+const uint64_t HARNESS_MICROS_PER_SECOND = 1000000ULL;
+
+// The sketch's entry points and the parts of it the tests look at
+void setup();
+void loop();
+extern ClockDisplay clockDisplay;
+extern ClockOptions options;
+extern Timekeeper timekeeper;
+extern TaskScheduler taskScheduler;
+
+/**
+ * Loads an input capture and starts replaying it, then starts the clock (runs setup()).
+ * The capture is kept for as long as the harness runs.
+ *
+ * @return false if the capture can't be read
+ */
+bool startClock(const char *capturePath);
+
+/**
+ * Runs the sketch's main loop until the virtual time reaches the given time (in microseconds since the clock started)
+ */
+void runClockUntil(uint64_t microseconds);
+
+/**
+ * Writes the display's front buffer (ClockDisplay::LED_COUNT values) to a file, for Tools/render_frame.py
+ *
+ * @return false if the file can't be written
+ */
+bool dumpFrontBuffer(const char *path);
+
+/**
+ * Checks a condition, reporting it (with its location) if it doesn't hold
+ */
+#define HARNESS_CHECK(condition) harnessCheck((condition), #condition, __FILE__, __LINE__)
+
+void harnessCheck(bool condition, const char *text, const char *file, int line);
+
+/**
+ * Prints the result of the test, returning its exit status (0 if every check passed)
+ */
+int finishTest(const char *name);
+
+#endif
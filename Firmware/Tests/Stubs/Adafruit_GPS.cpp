@@ -0,0 +1,147 @@
+#include "Adafruit_GPS.h"
+
+/**
+ * Gets the start of the field following the given position (or NULL after the last field)
+ */
+static char *nextField(char *position) {
+  char *comma = strchr(position, ',');
+  return comma != NULL ? comma + 1 : NULL;
+}
+
+static uint8_t parseTwoDigits(const char *text) {
+  return static_cast<uint8_t>((text[0] - '0') * 10 + (text[1] - '0'));
+}
+
+static uint8_t parseHexDigit(char digit) {
+  return digit >= 'A' ? digit - 'A' + 10 : digit - '0';
+}
+
+Adafruit_GPS::Adafruit_GPS(Stream *stream) {
+  this->stream = stream;
+  hour = minute = seconds = year = month = day = 0;
+  milliseconds = 0;
+  latitude_fixed = longitude_fixed = 0;
+  lat = lon = 0;
+  fix = false;
+  memset(lines, 0, sizeof(lines));
+  currentLine = 0;
+  lineIndex = 0;
+  received = false;
+}
+
+bool Adafruit_GPS::begin(uint32_t /* baud */) {
+  return true;
+}
+
+void Adafruit_GPS::sendCommand(const char *command) {
+  stream->println(command);
+}
+
+size_t Adafruit_GPS::available() {
+  return stream->available();
+}
+
+char Adafruit_GPS::read() {
+  int value = stream->read();
+  if (value < 0) {
+    return 0;
+  }
+
+  char c = static_cast<char>(value);
+  if (c == '\n') {
+    // The finished line becomes lastNMEA(), and the next one is read into the other buffer
+    lines[currentLine][lineIndex] = 0;
+    currentLine ^= 1;
+    lineIndex = 0;
+    received = true;
+  } else if (lineIndex < MAX_LINE_LENGTH - 1) {
+    lines[currentLine][lineIndex++] = c;
+  }
+  return c;
+}
+
+bool Adafruit_GPS::newNMEAreceived() {
+  return received;
+}
+
+char *Adafruit_GPS::lastNMEA() {
+  received = false;
+  return lines[currentLine ^ 1];
+}
+
+bool Adafruit_GPS::parse(char *sentence) {
+  // Check the checksum
+  char *star = strchr(sentence, '*');
+  if (sentence[0] != '$' || star == NULL || star[1] == 0 || star[2] == 0) {
+    return false;
+  }
+  uint8_t checksum = 0;
+  for (char *c = sentence + 1; c < star; ++c) {
+    checksum ^= static_cast<uint8_t>(*c);
+  }
+  if (checksum != (parseHexDigit(star[1]) << 4 | parseHexDigit(star[2]))) {
+    return false;
+  }
+  if (strncmp(sentence + 3, "RMC,", 4) != 0) {
+    return false;
+  }
+
+  // $GPRMC,hhmmss.sss,A,ddmm.mmmm,N,dddmm.mmmm,W,speed,course,ddmmyy,...
+  char *field = nextField(sentence);
+  if (field != NULL && strlen(field) >= 6 && field[0] != ',') {
+    hour = parseTwoDigits(field);
+    minute = parseTwoDigits(field + 2);
+    seconds = parseTwoDigits(field + 4);
+    milliseconds = field[6] == '.' ? static_cast<uint16_t>(atoi(field + 7)) : 0;
+  }
+  field = field != NULL ? nextField(field) : NULL;
+  fix = field != NULL && field[0] == 'A';
+
+  field = field != NULL ? nextField(field) : NULL;
+  if (field != NULL && field[0] != ',') {
+    latitude_fixed = parseCoordinate(field);
+  }
+  field = field != NULL ? nextField(field) : NULL;
+  if (field != NULL && field[0] != ',') {
+    lat = field[0];
+  }
+  field = field != NULL ? nextField(field) : NULL;
+  if (field != NULL && field[0] != ',') {
+    longitude_fixed = parseCoordinate(field);
+  }
+  field = field != NULL ? nextField(field) : NULL;
+  if (field != NULL && field[0] != ',') {
+    lon = field[0];
+  }
+
+  // Skip the speed and course
+  field = field != NULL ? nextField(field) : NULL;
+  field = field != NULL ? nextField(field) : NULL;
+  field = field != NULL ? nextField(field) : NULL;
+  if (field != NULL && strlen(field) >= 6 && field[0] != ',') {
+    day = parseTwoDigits(field);
+    month = parseTwoDigits(field + 2);
+    year = parseTwoDigits(field + 4);
+  }
+  return true;
+}
+
+int32_t Adafruit_GPS::parseCoordinate(const char *field) {
+  const char *point = strchr(field, '.');
+  if (point == NULL || point - field < 3) {
+    return 0;
+  }
+  int32_t degrees = 0;
+  for (const char *c = field; c < point - 2; ++c) {
+    degrees = degrees * 10 + (*c - '0');
+  }
+
+  // Minutes, in units of 10^-4 minutes
+  int32_t minutes = parseTwoDigits(point - 2) * 10000L;
+  int32_t scale = 1000;
+  for (const char *c = point + 1; *c >= '0' && *c <= '9' && scale > 0; ++c) {
+    minutes += (*c - '0') * scale;
+    scale /= 10;
+  }
+  return degrees * 10000000L + minutes * 1000L / 60;
+}
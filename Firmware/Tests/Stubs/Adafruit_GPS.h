@@ -0,0 +1,47 @@
+#ifndef HOST_ADAFRUIT_GPS_H
+#define HOST_ADAFRUIT_GPS_H
+
+#include "Arduino.h"
+
+#define PMTK_SET_NMEA_UPDATE_100_MILLIHERTZ "$PMTK220,10000*2F"
+#define PMTK_SET_NMEA_OUTPUT_RMCGGA "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28"
+
+/**
+ * The parts of Adafruit_GPS used by the clock: sentences are read from a stream one character at a time, and RMC
+ * sentences (the only ones which carry the date) are parsed
+ */
+class Adafruit_GPS {
+public:
+  Adafruit_GPS(Stream *stream);
+
+  bool begin(uint32_t baud);
+  void sendCommand(const char *command);
+
+  size_t available();
+  char read();
+  bool newNMEAreceived();
+  char *lastNMEA();
+  bool parse(char *sentence);
+
+  uint8_t hour, minute, seconds, year, month, day;
+  uint16_t milliseconds;
+  int32_t latitude_fixed, longitude_fixed;
+  char lat, lon;
+  bool fix;
+
+private:
+  static const uint8_t MAX_LINE_LENGTH = 120;
+
+  Stream *stream;
+  char lines[2][MAX_LINE_LENGTH];
+  uint8_t currentLine;
+  uint8_t lineIndex;
+  bool received;
+
+  /**
+   * Parses ddmm.mmmm (or dddmm.mmmm) into degrees * 10^7
+   */
+  static int32_t parseCoordinate(const char *field);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+ * The parts of the Arduino core used by the clock, for host builds (see Firmware/Tests/Makefile)
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+template<typename A, typename B>
+inline typename std::common_type<A, B>::type min(A a, B b) {
+  return a < b ? a : b;
+}
+
+template<typename A, typename B>
+inline typename std::common_type<A, B>::type max(A a, B b) {
+  return a > b ? a : b;
+}
+
+template<typename A, typename B, typename C>
+inline A constrain(A value, B low, C high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+// Wall clock time (the clock itself uses ClockTime.h, which runs on virtual time in host builds)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long milliseconds);
+void delayMicroseconds(unsigned int microseconds);
+
+const uint8_t A0 = 14;
+const uint8_t A1 = 15;
+const uint8_t A2 = 16;
+const uint8_t A3 = 17;
+const uint8_t A4 = 18;
+const uint8_t A5 = 19;
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+
+  size_t print(const char *text) {
+    size_t count = 0;
+    while (*text != 0) {
+      count += write(static_cast<uint8_t>(*text++));
+    }
+    return count;
+  }
+
+  size_t println(const char *text) {
+    return print(text) + print("\r\n");
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#include "EEPROM.h"
+#include <string.h>
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() {
+  memset(data, 0xFF, sizeof(data));
+}
+
+uint8_t EEPROMClass::read(int address) {
+  return address >= 0 && address < static_cast<int>(sizeof(data)) ? data[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && address < static_cast<int>(sizeof(data))) {
+    data[address] = value;
+  }
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  write(address, value);
+}
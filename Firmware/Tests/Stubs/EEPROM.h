@@ -0,0 +1,42 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * The ATmega328P's 1 KB EEPROM, erased (all 0xFF) at startup
+ */
+class EEPROMClass {
+public:
+  EEPROMClass();
+
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+
+  template<typename T>
+  T &get(int address, T &value) {
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      bytes[i] = read(address + static_cast<int>(i));
+    }
+    return value;
+  }
+
+  template<typename T>
+  const T &put(int address, const T &value) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      update(address + static_cast<int>(i), bytes[i]);
+    }
+    return value;
+  }
+
+private:
+  uint8_t data[1024];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,27 @@
+#include "Arduino.h"
+#include "ClockTime.h"
+
+volatile uint8_t PINB = 0xFF, PINC = 0xFF, PIND = 0xFF, DDRB, DDRC, DDRD, PORTB, PORTC, PORTD;
+volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TCNT2, OCR2A, TIFR2;
+volatile uint8_t ADCSRA, ADCSRB, ADMUX;
+volatile uint16_t ADC;
+volatile uint8_t TWBR, TWCR, TWDR, TWSR;
+volatile uint8_t PCMSK0, PCIFR, PCICR;
+volatile uint8_t MCUSR, WDTCSR;
+volatile uint16_t SP;
+
+unsigned long millis() {
+  return clockMillis();
+}
+
+unsigned long micros() {
+  return clockMicros();
+}
+
+void delay(unsigned long milliseconds) {
+  clockDelay(milliseconds);
+}
+
+void delayMicroseconds(unsigned int microseconds) {
+  advanceClockTime(microseconds);
+}
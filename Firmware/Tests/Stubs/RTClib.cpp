@@ -0,0 +1,126 @@
+#include "RTClib.h"
+
+static const uint8_t DAYS_IN_MONTH[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30 };
+
+/**
+ * Gets the number of days since 2000-01-01 of the given date
+ */
+static uint16_t dateToDays(uint16_t year, uint8_t month, uint8_t day) {
+  if (year >= 2000) {
+    year -= 2000;
+  }
+  uint16_t days = day;
+  for (uint8_t i = 1; i < month; ++i) {
+    days += DAYS_IN_MONTH[i - 1];
+  }
+  if (month > 2 && year % 4 == 0) {
+    ++days;
+  }
+  return days + 365 * year + (year + 3) / 4 - 1;
+}
+
+TimeSpan::TimeSpan(int32_t seconds) : seconds(seconds) {
+}
+
+TimeSpan::TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+    : seconds(static_cast<int32_t>(days) * 86400L + static_cast<int32_t>(hours) * 3600 + static_cast<int32_t>(minutes) * 60 + seconds) {
+}
+
+int32_t TimeSpan::totalseconds() const {
+  return seconds;
+}
+
+DateTime::DateTime(uint32_t unixTime) {
+  uint32_t t = unixTime - SECONDS_FROM_1970_TO_2000;
+  ss = t % 60;
+  t /= 60;
+  mm = t % 60;
+  t /= 60;
+  hh = t % 24;
+  uint16_t days = t / 24;
+  bool leap;
+  for (yOff = 0;; ++yOff) {
+    leap = yOff % 4 == 0;
+    if (days < 365U + leap) {
+      break;
+    }
+    days -= 365 + leap;
+  }
+  for (m = 1; m < 12; ++m) {
+    uint8_t daysPerMonth = DAYS_IN_MONTH[m - 1];
+    if (leap && m == 2) {
+      ++daysPerMonth;
+    }
+    if (days < daysPerMonth) {
+      break;
+    }
+    days -= daysPerMonth;
+  }
+  d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+  yOff = static_cast<uint8_t>(year >= 2000 ? year - 2000 : year);
+  m = month;
+  d = day;
+  hh = hour;
+  mm = minute;
+  ss = second;
+}
+
+bool DateTime::isValid() const {
+  if (yOff >= 100) {
+    return false;
+  }
+  DateTime other(unixtime());
+  return yOff == other.yOff && m == other.m && d == other.d && hh == other.hh && mm == other.mm && ss == other.ss;
+}
+
+uint16_t DateTime::year() const {
+  return 2000 + yOff;
+}
+
+uint8_t DateTime::month() const {
+  return m;
+}
+
+uint8_t DateTime::day() const {
+  return d;
+}
+
+uint8_t DateTime::hour() const {
+  return hh;
+}
+
+uint8_t DateTime::minute() const {
+  return mm;
+}
+
+uint8_t DateTime::second() const {
+  return ss;
+}
+
+uint8_t DateTime::isPM() const {
+  return hh >= 12;
+}
+
+uint8_t DateTime::dayOfTheWeek() const {
+  // 2000-01-01 was a Saturday
+  return (dateToDays(yOff, m, d) + 6) % 7;
+}
+
+uint32_t DateTime::unixtime() const {
+  return ((static_cast<uint32_t>(dateToDays(yOff, m, d)) * 24 + hh) * 60 + mm) * 60 + ss + SECONDS_FROM_1970_TO_2000;
+}
+
+DateTime DateTime::operator+(const TimeSpan &span) const {
+  return DateTime(unixtime() + span.totalseconds());
+}
+
+DateTime DateTime::operator-(const TimeSpan &span) const {
+  return DateTime(unixtime() - span.totalseconds());
+}
+
+TimeSpan DateTime::operator-(const DateTime &right) const {
+  return TimeSpan(static_cast<int32_t>(unixtime() - right.unixtime()));
+}
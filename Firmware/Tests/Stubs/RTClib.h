@@ -0,0 +1,52 @@
+#ifndef HOST_RTCLIB_H
+#define HOST_RTCLIB_H
+
+#include "Arduino.h"
+
+/*
+ * RTClib's DateTime and TimeSpan (the same calendar arithmetic, for dates from 2000 to 2099)
+ */
+
+const uint32_t SECONDS_FROM_1970_TO_2000 = 946684800;
+
+class TimeSpan {
+public:
+  TimeSpan(int32_t seconds = 0);
+  TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds);
+
+  int32_t totalseconds() const;
+
+private:
+  int32_t seconds;
+};
+
+class DateTime {
+public:
+  DateTime(uint32_t unixTime = SECONDS_FROM_1970_TO_2000);
+  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0);
+
+  bool isValid() const;
+  uint16_t year() const;
+  uint8_t month() const;
+  uint8_t day() const;
+  uint8_t hour() const;
+  uint8_t minute() const;
+  uint8_t second() const;
+  uint8_t isPM() const;
+  uint8_t dayOfTheWeek() const;
+  uint32_t unixtime() const;
+
+  DateTime operator+(const TimeSpan &span) const;
+  DateTime operator-(const TimeSpan &span) const;
+  TimeSpan operator-(const DateTime &right) const;
+
+private:
+  uint8_t yOff;
+  uint8_t m;
+  uint8_t d;
+  uint8_t hh;
+  uint8_t mm;
+  uint8_t ss;
+};
+
+#endif
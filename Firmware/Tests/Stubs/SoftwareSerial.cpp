@@ -0,0 +1,39 @@
+#include "SoftwareSerial.h"
+
+SoftwareSerial *SoftwareSerial::activeSerial = NULL;
+
+SoftwareSerial::SoftwareSerial(uint8_t /* receivePin */, uint8_t /* transmitPin */) {
+}
+
+void SoftwareSerial::begin(long /* baud */) {
+  listen();
+}
+
+bool SoftwareSerial::listen() {
+  bool changed = activeSerial != this;
+  activeSerial = this;
+  return changed;
+}
+
+bool SoftwareSerial::isListening() {
+  return activeSerial == this;
+}
+
+int SoftwareSerial::available() {
+  return 0;
+}
+
+int SoftwareSerial::read() {
+  return -1;
+}
+
+int SoftwareSerial::peek() {
+  return -1;
+}
+
+size_t SoftwareSerial::write(uint8_t /* value */) {
+  return 1;
+}
+
+void SoftwareSerial::flush() {
+}
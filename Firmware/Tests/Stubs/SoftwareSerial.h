@@ -0,0 +1,27 @@
+#ifndef HOST_SOFTWARE_SERIAL_H
+#define HOST_SOFTWARE_SERIAL_H
+
+#include "Arduino.h"
+
+/**
+ * A serial port with nothing attached (virtual time builds replay the GPS from InputReplay instead)
+ */
+class SoftwareSerial : public Stream {
+public:
+  SoftwareSerial(uint8_t receivePin, uint8_t transmitPin);
+
+  void begin(long baud);
+  bool listen();
+  bool isListening();
+
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t value);
+  void flush();
+
+private:
+  static SoftwareSerial *activeSerial;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+// Interrupt handlers are ordinary functions (a host harness calls them itself)
+#define ISR(vector) extern "C" void vector()
+
+inline void cli() {
+}
+
+inline void sei() {
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+/*
+ * ATmega328P registers, as plain variables (defined in HostStubs.cpp)
+ */
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_MEM_ADDR(reg) 0
+
+extern volatile uint8_t PINB, PINC, PIND, DDRB, DDRC, DDRD, PORTB, PORTC, PORTD;
+extern volatile uint8_t TCCR2A, TCCR2B, TIMSK2, TCNT2, OCR2A, TIFR2;
+extern volatile uint8_t ADCSRA, ADCSRB, ADMUX;
+extern volatile uint16_t ADC;
+extern volatile uint8_t TWBR, TWCR, TWDR, TWSR;
+extern volatile uint8_t PCMSK0, PCIFR, PCICR;
+extern volatile uint8_t MCUSR, WDTCSR;
+extern volatile uint16_t SP;
+
+// Port bits
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+// Timer 2
+#define WGM21 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define OCIE2A 1
+#define OCF2A 1
+
+// ADC
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define REFS0 6
+
+// TWI
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+// Pin change interrupts
+#define PCIE0 0
+#define PCIF0 0
+
+// Watchdog
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+
+#endif
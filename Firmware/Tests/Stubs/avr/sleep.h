@@ -0,0 +1,22 @@
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(uint8_t /* mode */) {
+}
+
+inline void sleep_enable() {
+}
+
+inline void sleep_disable() {
+}
+
+// Sleeping is only used to wait for timer 2, which wakes the CPU straight away
+extern "C" void TIMER2_COMPA_vect();
+
+inline void sleep_cpu() {
+  TIMER2_COMPA_vect();
+}
+
+#endif
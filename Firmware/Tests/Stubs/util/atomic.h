@@ -0,0 +1,8 @@
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+// A host build has no interrupts to hold off
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) for (bool atomicBlockOnce = true; atomicBlockOnce; atomicBlockOnce = false)
+
+#endif
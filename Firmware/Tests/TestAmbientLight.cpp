@@ -0,0 +1,124 @@
+#include "ClockHarness.h"
+#include "AmbientLight.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Checks the ambient light sensor (AmbientLight) against the ADC registers: the IIR filter follows the readings, the
+ * hysteresis holds the light level through sensor noise, and the light level maps onto the night..daytime brightness.
+ */
+
+// The sensor configuration of Faux_Analog_Clock.ino
+const uint8_t ADC_CHANNEL = 6;
+const uint16_t DARK_LEVEL = 64;
+const uint16_t BRIGHT_LEVEL = 768;
+
+const uint8_t NIGHT_BRIGHTNESS = 20;
+const uint8_t DAYTIME_BRIGHTNESS = 200;
+
+// The peak sensor noise (in ADC units) added to every reading, below the hysteresis
+const int16_t NOISE = 12;
+
+static uint32_t noiseState = 1;
+
+/**
+ * Deterministic noise between -NOISE and NOISE
+ */
+static int16_t nextNoise() {
+  noiseState = noiseState * 1103515245UL + 12345UL;
+  return static_cast<int16_t>((noiseState >> 16) % (2 * NOISE + 1)) - NOISE;
+}
+
+/**
+ * Finishes the pending conversion with the given reading, then lets the sensor take it
+ */
+static void convert(AmbientLight &light, int16_t reading) {
+  ADC = static_cast<uint16_t>(constrain(reading, 0, 1023));
+  ADCSRA &= ~_BV(ADSC);
+  light.update();
+}
+
+int main() {
+  AmbientLight light(ADC_CHANNEL, DARK_LEVEL, BRIGHT_LEVEL);
+
+  // begin() selects the channel and starts a single conversion
+  light.begin();
+  HARNESS_CHECK(ADMUX == (_BV(REFS0) | ADC_CHANNEL));
+  HARNESS_CHECK((ADCSRA & _BV(ADEN)) != 0 && (ADCSRA & _BV(ADSC)) != 0);
+
+  // Nothing is read until the conversion has finished, and every update starts the next one
+  ADC = 400;
+  light.update();
+  HARNESS_CHECK(light.getLightLevel() == 0);
+  convert(light, 400);
+  HARNESS_CHECK(light.getLightLevel() == 400);
+  HARNESS_CHECK((ADCSRA & _BV(ADSC)) != 0);
+
+  // Noise around a steady level doesn't move the light level
+  for (uint16_t i = 0; i < 500; ++i) {
+    convert(light, 400 + nextNoise());
+    HARNESS_CHECK(light.getLightLevel() == 400);
+  }
+
+  // A noisy ramp moves the light level up only, in steps larger than the hysteresis, lagging behind the ramp
+  uint16_t previousLevel = light.getLightLevel();
+  uint16_t steps = 0;
+  for (int16_t ramp = 400; ramp <= 900; ramp += 2) {
+    convert(light, ramp + nextNoise());
+    uint16_t level = light.getLightLevel();
+    HARNESS_CHECK(level >= previousLevel);
+    if (level != previousLevel) {
+      HARNESS_CHECK(level - previousLevel > AMBIENT_LIGHT_HYSTERESIS);
+      ++steps;
+    }
+    HARNESS_CHECK(level <= ramp + NOISE);
+    previousLevel = level;
+  }
+  HARNESS_CHECK(steps >= (900 - 400) / (2 * AMBIENT_LIGHT_HYSTERESIS));
+  for (uint16_t i = 0; i < 200; ++i) {
+    convert(light, 900 + nextNoise());
+  }
+  HARNESS_CHECK(abs(static_cast<int16_t>(light.getLightLevel()) - 900) <= AMBIENT_LIGHT_HYSTERESIS + NOISE);
+
+  // The filter settles on a step like a first order IIR filter (each reading contributes 1/16th)
+  AmbientLight step(ADC_CHANNEL, DARK_LEVEL, BRIGHT_LEVEL);
+  step.end();
+  light.end();
+  HARNESS_CHECK((ADCSRA & _BV(ADEN)) == 0);
+  step.begin();
+  convert(step, 0);
+  double expected = 0;
+  for (uint16_t i = 0; i < 100; ++i) {
+    convert(step, 1023);
+    expected += (1023 - expected) / (1 << AMBIENT_LIGHT_FILTER_SHIFT);
+    HARNESS_CHECK(fabs(step.getLightLevel() - expected) <= AMBIENT_LIGHT_HYSTERESIS + 2);
+  }
+  HARNESS_CHECK(step.getLightLevel() >= 1023 - AMBIENT_LIGHT_HYSTERESIS - 2);
+  step.end();
+
+  // The light level maps linearly from the night brightness (in the dark) to the daytime brightness (in bright light)
+  uint8_t previousBrightness = 0;
+  for (uint16_t reading = 0; reading <= 1023; reading += 31) {
+    AmbientLight level(ADC_CHANNEL, DARK_LEVEL, BRIGHT_LEVEL);
+    level.begin();
+    convert(level, reading);
+    uint8_t brightness = level.getBrightness(NIGHT_BRIGHTNESS, DAYTIME_BRIGHTNESS);
+    if (reading <= DARK_LEVEL) {
+      HARNESS_CHECK(brightness == NIGHT_BRIGHTNESS);
+    } else if (reading >= BRIGHT_LEVEL) {
+      HARNESS_CHECK(brightness == DAYTIME_BRIGHTNESS);
+    } else {
+      uint8_t expectedBrightness = NIGHT_BRIGHTNESS + (reading - DARK_LEVEL) * (DAYTIME_BRIGHTNESS - NIGHT_BRIGHTNESS) / (BRIGHT_LEVEL - DARK_LEVEL);
+      HARNESS_CHECK(brightness == expectedBrightness);
+    }
+    HARNESS_CHECK(brightness >= previousBrightness);
+    previousBrightness = brightness;
+
+    // A daytime brightness at or below the night brightness stays at the night brightness
+    HARNESS_CHECK(level.getBrightness(DAYTIME_BRIGHTNESS, NIGHT_BRIGHTNESS) == DAYTIME_BRIGHTNESS);
+    level.end();
+  }
+
+  return finishTest("TestAmbientLight");
+}
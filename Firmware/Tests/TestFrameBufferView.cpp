@@ -0,0 +1,174 @@
+#include "ClockHarness.h"
+#include "FrameBufferView.h"
+#include <stdio.h>
+
+/*
+ * Checks the ring drawing primitives of FrameBufferView (setArc(), setMirroredArc(), setScaledArc(),
+ * setSteppedGradient() and copyRotated()) against a value by value model: wrapping around both ends of the ring,
+ * zero length calls, scaling between 60 and 12 position rings, and rotations.
+ */
+
+const uint8_t MAX_RING_COUNT = 60;
+
+/**
+ * A view of its own ring buffer, recording the indices it modifies, and the values the ring should hold
+ */
+struct Ring {
+  uint8_t count;
+  uint8_t values[MAX_RING_COUNT];
+  uint8_t expected[MAX_RING_COUNT];
+  FrameBufferDirtyRange<uint8_t> dirty;
+  FrameBufferView view;
+
+  Ring(uint8_t count) : count(count), view(values, count, &dirty) {
+    memset(values, 0, sizeof(values));
+    memset(expected, 0, sizeof(expected));
+  }
+
+  /**
+   * Sets the expected values of an arc, clockwise from the given index
+   */
+  void expectArc(int startIndex, int length, uint8_t value) {
+    for (int i = 0; i < length; ++i) {
+      expected[(startIndex + i) % count] = value;
+    }
+  }
+
+  /**
+   * Returns true if the ring holds the expected values
+   */
+  bool matches() const {
+    for (uint8_t i = 0; i < count; ++i) {
+      if (values[i] != expected[i]) {
+        fprintf(stderr, "Index %u of %u: %u, expected %u\n", i, count, values[i], expected[i]);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Clears the ring, its expected values and its dirty range
+   */
+  void clear() {
+    view.setAllValues(0);
+    memset(expected, 0, sizeof(expected));
+    dirty.clear();
+  }
+};
+
+int main() {
+  Ring ring(12);
+
+  // Arcs wrap around the end of the ring, marking both runs as modified
+  ring.view.setArc(11, 3, 10);
+  ring.expectArc(11, 3, 10);
+  HARNESS_CHECK(ring.matches());
+  HARNESS_CHECK(ring.dirty.start == 0 && ring.dirty.end == 12);
+  ring.clear();
+  ring.view.setArc(0, 3, 10);
+  ring.expectArc(0, 3, 10);
+  HARNESS_CHECK(ring.matches());
+  HARNESS_CHECK(ring.dirty.start == 0 && ring.dirty.end == 3);
+  ring.clear();
+  ring.view.setArc(12 + 5, 40, 10);
+  ring.expectArc(5, 12, 10);
+  HARNESS_CHECK(ring.matches());
+
+  // Mirrored arcs run counterclockwise, wrapping around the start of the ring
+  ring.clear();
+  ring.view.setMirroredArc(0, 3, 20);
+  ring.expectArc(10, 3, 20);
+  HARNESS_CHECK(ring.matches());
+  ring.clear();
+  ring.view.setMirroredArc(11, 3, 20);
+  ring.expectArc(9, 3, 20);
+  HARNESS_CHECK(ring.matches());
+  HARNESS_CHECK(ring.dirty.start == 9 && ring.dirty.end == 12);
+  ring.clear();
+  ring.view.setMirroredArc(4, 1, 20);
+  ring.expectArc(4, 1, 20);
+  HARNESS_CHECK(ring.matches());
+
+  // Zero length calls change nothing
+  ring.clear();
+  ring.view.setArc(0, 0, 30);
+  ring.view.setArc(11, 0, 30);
+  ring.view.setMirroredArc(0, 0, 30);
+  ring.view.setMirroredArc(11, 0, 30);
+  ring.view.setScaledArc(30, 0, 60, 30);
+  ring.view.setSteppedGradient(5, 0, 4, 30, 60);
+  HARNESS_CHECK(ring.matches());
+  HARNESS_CHECK(ring.dirty.isEmpty());
+
+  // Minutes (60 positions) scale down to a 12 position ring, wrapping around its end
+  ring.clear();
+  ring.view.setScaledArc(0, 60, 60, 40);
+  ring.expectArc(0, 12, 40);
+  HARNESS_CHECK(ring.matches());
+  ring.clear();
+  ring.view.setScaledArc(55, 5, 60, 40);
+  ring.expectArc(11, 1, 40);
+  HARNESS_CHECK(ring.matches());
+  ring.clear();
+  ring.view.setScaledArc(50, 20, 60, 40);
+  ring.expectArc(10, 4, 40);
+  HARNESS_CHECK(ring.matches());
+
+  // Hours (12 positions) scale up to a 60 position ring, wrapping around its end
+  Ring minutes(60);
+  minutes.view.setScaledArc(11, 1, 12, 50);
+  minutes.expectArc(55, 5, 50);
+  HARNESS_CHECK(minutes.matches());
+  minutes.clear();
+  minutes.view.setScaledArc(11, 2, 12, 50);
+  minutes.expectArc(55, 10, 50);
+  HARNESS_CHECK(minutes.matches());
+  minutes.clear();
+  minutes.view.setScaledArc(3, 4, 3 * 4, 50);
+  minutes.expectArc(15, 20, 50);
+  HARNESS_CHECK(minutes.matches());
+
+  // A gradient is one arc per step, from the start value to the end value, wrapping around the end of the ring
+  ring.clear();
+  ring.view.setSteppedGradient(10, 8, 4, 0, 90);
+  ring.expectArc(10, 2, 0);
+  ring.expectArc(12, 2, 30);
+  ring.expectArc(14, 2, 60);
+  ring.expectArc(16, 2, 90);
+  HARNESS_CHECK(ring.matches());
+  ring.clear();
+  ring.view.setSteppedGradient(0, 12, 1, 70, 10);
+  ring.expectArc(0, 12, 70);
+  HARNESS_CHECK(ring.matches());
+  ring.clear();
+  ring.view.setSteppedGradient(11, 3, 10, 90, 30);
+  ring.expectArc(11, 1, 90);
+  ring.expectArc(12, 1, 60);
+  ring.expectArc(13, 1, 30);
+  HARNESS_CHECK(ring.matches());
+
+  // Rotations by 0 and by the ring size copy the values as they are; others move them clockwise
+  Ring source(12);
+  for (uint8_t i = 0; i < 12; ++i) {
+    source.view.setValue(i, i + 1);
+  }
+  const uint8_t rotations[] = { 0, 1, 11, 12, 13 };
+  for (uint8_t r = 0; r < sizeof(rotations); ++r) {
+    ring.clear();
+    ring.view.copyRotated(source.view, rotations[r]);
+    for (uint8_t i = 0; i < 12; ++i) {
+      ring.expected[(i + rotations[r]) % 12] = i + 1;
+    }
+    HARNESS_CHECK(ring.matches());
+    HARNESS_CHECK(ring.dirty.start == 0 && ring.dirty.end == 12);
+  }
+
+  // Rings of different sizes aren't copied
+  minutes.clear();
+  minutes.view.copyRotated(source.view, 0);
+  HARNESS_CHECK(minutes.matches());
+  HARNESS_CHECK(minutes.dirty.isEmpty());
+
+  return finishTest("TestFrameBufferView");
+}
@@ -0,0 +1,111 @@
+#include "ClockHarness.h"
+#include "ClockBoard.h"
+#include <stdio.h>
+
+/*
+ * Measures the virtual frame time of Charlieplex displays of 14 (this clock's board), 16, 18 and 20 lines, and checks
+ * that it grows with the number of lit LEDs: every lit LED takes a 255 iteration slot of the scan, whatever the board.
+ * The larger boards are stubs (their lines are made up), built from the same scan code as the clock's display, with
+ * uint16_t indices beyond 255 LEDs. These are host figures from the scan's cycle count (see Kernels.h), not
+ * measurements of a real AVR.
+ */
+
+/**
+ * Made-up lines for the stub boards (the first LineCount are used)
+ */
+constexpr CharlieplexLine STUB_BOARD_LINES[] = {
+  { CLOCK_BOARD_PORT_D, 0 }, { CLOCK_BOARD_PORT_D, 1 }, { CLOCK_BOARD_PORT_D, 2 }, { CLOCK_BOARD_PORT_D, 3 },
+  { CLOCK_BOARD_PORT_D, 4 }, { CLOCK_BOARD_PORT_D, 5 }, { CLOCK_BOARD_PORT_D, 6 }, { CLOCK_BOARD_PORT_D, 7 },
+  { CLOCK_BOARD_PORT_B, 0 }, { CLOCK_BOARD_PORT_B, 1 }, { CLOCK_BOARD_PORT_B, 2 }, { CLOCK_BOARD_PORT_B, 3 },
+  { CLOCK_BOARD_PORT_B, 4 }, { CLOCK_BOARD_PORT_B, 5 }, { CLOCK_BOARD_PORT_B, 6 }, { CLOCK_BOARD_PORT_B, 7 },
+  { CLOCK_BOARD_PORT_C, 0 }, { CLOCK_BOARD_PORT_C, 1 }, { CLOCK_BOARD_PORT_C, 2 }, { CLOCK_BOARD_PORT_C, 3 }
+};
+
+/**
+ * A stub board with the first LineCount lines of STUB_BOARD_LINES, and its LEDs in scan order
+ */
+template<uint8_t LineCount>
+struct StubCharlieplexBoard {
+  static constexpr CharlieplexLine line(uint8_t index) {
+    return STUB_BOARD_LINES[index];
+  }
+
+  static constexpr uint16_t logicalLED(uint16_t physicalLED) {
+    return physicalLED;
+  }
+};
+
+template<>
+struct CharlieplexBoard<16> : StubCharlieplexBoard<16> {};
+
+template<>
+struct CharlieplexBoard<18> : StubCharlieplexBoard<18> {};
+
+template<>
+struct CharlieplexBoard<20> : StubCharlieplexBoard<20> {};
+
+// The display's templates, for the stub boards as well as the clock's (this replaces ClockDisplay.o in the link)
+#include "ClockDisplay.cpp"
+
+template class CharlieplexDisplay<16, uint8_t>;
+template class CharlieplexDisplay<18, uint16_t>;
+template class CharlieplexDisplay<20, uint16_t>;
+
+/**
+ * Measures the virtual time taken by one frame of the given display
+ */
+template<uint8_t LineCount, typename Index>
+static uint32_t measureFrameMicros(CharlieplexDisplay<LineCount, Index> &display) {
+  uint64_t startMicros = getClockTime();
+  display.display();
+  return static_cast<uint32_t>(getClockTime() - startMicros);
+}
+
+/**
+ * Measures a display with every LED, half the LEDs and no LED lit, returning the frame time with every LED lit
+ */
+template<uint8_t LineCount, typename Index>
+static uint32_t checkFrameTime() {
+  static CharlieplexDisplay<LineCount, Index> display;
+  const Index ledCount = CharlieplexDisplay<LineCount, Index>::LED_COUNT;
+
+  display.setAllLEDValues(255);
+  uint32_t fullMicros = measureFrameMicros(display);
+
+  // The frame time only depends on how many LEDs are lit, not on their values
+  display.setAllLEDValues(1);
+  HARNESS_CHECK(measureFrameMicros(display) == fullMicros);
+
+  // Half the LEDs take half the time
+  for (Index i = 0; i < ledCount; i += 2) {
+    display.setLEDValue(i, 0);
+  }
+  uint32_t halfMicros = measureFrameMicros(display);
+  HARNESS_CHECK(halfMicros >= fullMicros / 2 - 1 && halfMicros <= fullMicros / 2 + 1);
+
+  // A dark display sleeps for a fixed time
+  display.setAllLEDValues(0);
+  HARNESS_CHECK(measureFrameMicros(display) == static_cast<uint32_t>(CLOCK_DISPLAY_DARK_FRAME_TICKS) * 2);
+
+  printf("%u lines, %u LEDs: %lu.%lu ms per frame (%lu Hz) with every LED lit\n", LineCount, static_cast<unsigned>(ledCount),
+    static_cast<unsigned long>(fullMicros / 1000), static_cast<unsigned long>(fullMicros % 1000 / 100),
+    static_cast<unsigned long>(1000000UL / fullMicros));
+  return fullMicros;
+}
+
+/**
+ * Returns true if the frame time of a board is proportional to its LED count, compared with the clock's board
+ */
+static bool scalesWithLEDs(uint32_t frameMicros, uint16_t ledCount, uint32_t clockFrameMicros) {
+  uint32_t expectedMicros = static_cast<uint32_t>(static_cast<uint64_t>(clockFrameMicros) * ledCount / CLOCK_BOARD_LED_COUNT);
+  return frameMicros + 2 >= expectedMicros && frameMicros <= expectedMicros + 2;
+}
+
+int main() {
+  uint32_t clockFrameMicros = checkFrameTime<CLOCK_DISPLAY_PIN_COUNT, ClockDisplayIndex>();
+  HARNESS_CHECK(scalesWithLEDs(checkFrameTime<16, uint8_t>(), 16 * 15, clockFrameMicros));
+  HARNESS_CHECK(scalesWithLEDs(checkFrameTime<18, uint16_t>(), 18 * 17, clockFrameMicros));
+  HARNESS_CHECK(scalesWithLEDs(checkFrameTime<20, uint16_t>(), 20 * 19, clockFrameMicros));
+
+  return finishTest("TestFrameTime");
+}
@@ -0,0 +1,40 @@
+#include "ClockHarness.h"
+#include <stdio.h>
+
+/*
+ * Dumps the front buffer at a few moments of Captures/menu_frames.txt, for the Makefile to compare with the golden
+ * images in Golden/ (see Tools/render_frame.py): before the GPS sets the time, showing the time, and in the menu.
+ * Built without CLOCK_VIRTUAL_MIN_FRAME_MICROS, so the frames are the ones the clock really shows.
+ */
+
+struct GoldenFrame {
+  // When the frame is dumped (in microseconds since the clock started)
+  uint64_t microseconds;
+
+  // The name of the dump (and of its golden image)
+  const char *name;
+};
+
+const GoldenFrame GOLDEN_FRAMES[] = {
+  { 1500000ULL,  "startup" },
+  { 12500000ULL, "time" },
+  { 21500000ULL, "menu" },
+};
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s menu_frames.bin frame_directory\n", argv[0]);
+    return 2;
+  }
+  if (!startClock(argv[1])) {
+    return 2;
+  }
+
+  for (size_t i = 0; i < sizeof(GOLDEN_FRAMES) / sizeof(GOLDEN_FRAMES[0]); ++i) {
+    runClockUntil(GOLDEN_FRAMES[i].microseconds);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.bin", argv[2], GOLDEN_FRAMES[i].name);
+    HARNESS_CHECK(dumpFrontBuffer(path));
+  }
+  return finishTest("TestGoldenFrames");
+}
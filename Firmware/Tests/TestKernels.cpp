@@ -0,0 +1,65 @@
+#include "ClockHarness.h"
+#include "Kernels.h"
+#include <stdio.h>
+
+/*
+ * Checks fadeValues() against a model in plain int arithmetic for every (value, target, amount) triple, both when the
+ * destination changes and when it already holds the result, in one call longer than a byte can count.
+ */
+
+/**
+ * The value fadeValues() stores for a source value, and the flags it sets for it
+ */
+static uint8_t modelFadeValue(int value, int targetValue, int amount, int oldResult, uint8_t &flags) {
+  int distance = targetValue - value;
+  int result = distance > amount ? value + amount : (distance < -amount ? value - amount : targetValue);
+  if (result != targetValue) {
+    flags |= FADE_VALUES_ACTIVE;
+  }
+  if (result != oldResult) {
+    flags |= FADE_VALUES_CHANGED;
+  }
+  return static_cast<uint8_t>(result);
+}
+
+int main() {
+  // Every source value, twice
+  uint8_t source[512];
+  for (uint16_t i = 0; i < 512; ++i) {
+    source[i] = static_cast<uint8_t>(i);
+  }
+
+  uint32_t mismatchCount = 0;
+  for (uint16_t targetValue = 0; targetValue < 256; ++targetValue) {
+    for (uint16_t amount = 0; amount < 256; ++amount) {
+      // Faded in place, then again into a destination which already holds the results
+      uint8_t destination[512];
+      memcpy(destination, source, sizeof(destination));
+      uint8_t expected[512];
+      uint8_t expectedFlags = 0;
+      uint8_t expectedUnchangedFlags = 0;
+      for (uint16_t i = 0; i < 512; ++i) {
+        expected[i] = modelFadeValue(source[i], targetValue, amount, source[i], expectedFlags);
+        modelFadeValue(source[i], targetValue, amount, expected[i], expectedUnchangedFlags);
+      }
+
+      uint8_t flags = fadeValues(destination, destination, sizeof(destination), targetValue, amount);
+      bool matches = flags == expectedFlags && memcmp(destination, expected, sizeof(expected)) == 0;
+      uint8_t unchangedFlags = fadeValues(destination, source, sizeof(destination), targetValue, amount);
+      matches = matches && unchangedFlags == expectedUnchangedFlags && memcmp(destination, expected, sizeof(expected)) == 0;
+
+      // The flags of each value on its own (one inactive or unchanged value mustn't hide behind the others)
+      for (uint16_t value = 0; value < 256; ++value) {
+        uint8_t single = static_cast<uint8_t>(value);
+        uint8_t singleFlags = 0;
+        uint8_t expectedSingle = modelFadeValue(value, targetValue, amount, value, singleFlags);
+        matches = matches && fadeValues(&single, &single, 1, targetValue, amount) == singleFlags && single == expectedSingle;
+      }
+      if (!matches && mismatchCount++ < 10) {
+        fprintf(stderr, "Target %u, amount %u: flags %u/%u, expected %u/%u\n", targetValue, amount, flags, unchangedFlags, expectedFlags, expectedUnchangedFlags);
+      }
+    }
+  }
+  HARNESS_CHECK(mismatchCount == 0);
+  return finishTest("TestKernels");
+}
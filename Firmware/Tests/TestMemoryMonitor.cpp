@@ -0,0 +1,67 @@
+#include "ClockHarness.h"
+#include "MemoryMonitor.h"
+#include <string.h>
+
+/*
+ * Checks the memory monitor's measurements (memoryMonitorMeasure()) on a made-up 2 KB SRAM layout: painted like
+ * memoryPaint() does at boot, then used by a heap and a stack which grow over a session.
+ * The AVR's own layout (and memoryPaint() itself) can only be measured on the device or in a simulator.
+ */
+
+const uint16_t RAM_SIZE = 2048;
+const uint16_t STATIC_SIZE = 600;
+
+static uint8_t ram[RAM_SIZE];
+
+/**
+ * Uses the stack down to the given address (as calls and interrupts do), leaving the stack pointer there
+ */
+static const uint8_t *useStack(uint16_t deepestAddress) {
+  for (uint16_t i = deepestAddress; i < RAM_SIZE; ++i) {
+    if (ram[i] == MEMORY_PAINT_VALUE) {
+      ram[i] = 0;
+    }
+  }
+  return ram + deepestAddress;
+}
+
+/**
+ * Measures the layout with a heap ending at the given address and the stack pointer at the given one
+ */
+static void measure(uint16_t heapEnd, const uint8_t *stackPointer) {
+  memoryMonitorMeasure(ram, ram + STATIC_SIZE, ram + heapEnd, stackPointer, ram + RAM_SIZE - 1);
+}
+
+int main() {
+  // Nothing has been measured yet
+  HARNESS_CHECK(memoryStats.minimumFreeBytes == 0xFFFF);
+
+  // Paint the free SRAM, then use 48 bytes of stack and allocate 100 bytes of heap
+  memset(ram, 0, STATIC_SIZE);
+  memset(ram + STATIC_SIZE, MEMORY_PAINT_VALUE, RAM_SIZE - STATIC_SIZE);
+  const uint8_t *stackPointer = useStack(RAM_SIZE - 48);
+  memset(ram + STATIC_SIZE, 0, 100);
+  measure(STATIC_SIZE + 100, stackPointer);
+  HARNESS_CHECK(memoryStats.staticBytes == STATIC_SIZE);
+  HARNESS_CHECK(memoryStats.heapBytes == 100);
+  HARNESS_CHECK(memoryStats.stackBytes == 48);
+  HARNESS_CHECK(memoryStats.minimumFreeBytes == RAM_SIZE - STATIC_SIZE - 100 - 48);
+
+  // The stack's high-water mark stays after the stack unwinds, and so does the smallest gap
+  useStack(RAM_SIZE - 500);
+  measure(STATIC_SIZE + 100, stackPointer);
+  HARNESS_CHECK(memoryStats.stackBytes == 500);
+  HARNESS_CHECK(memoryStats.minimumFreeBytes == RAM_SIZE - STATIC_SIZE - 100 - 500);
+  measure(STATIC_SIZE + 100, stackPointer);
+  HARNESS_CHECK(memoryStats.stackBytes == 500);
+  HARNESS_CHECK(memoryStats.minimumFreeBytes == RAM_SIZE - STATIC_SIZE - 100 - 500);
+
+  // A heap which grows into the stack's high-water mark leaves no gap, and later measurements keep that minimum
+  measure(RAM_SIZE - 500, stackPointer);
+  HARNESS_CHECK(memoryStats.heapBytes == RAM_SIZE - 500 - STATIC_SIZE);
+  HARNESS_CHECK(memoryStats.minimumFreeBytes == 0);
+  measure(STATIC_SIZE + 100, stackPointer);
+  HARNESS_CHECK(memoryStats.minimumFreeBytes == 0);
+
+  return finishTest("TestMemoryMonitor");
+}
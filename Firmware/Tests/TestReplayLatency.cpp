@@ -0,0 +1,39 @@
+#include "ClockHarness.h"
+#include "Trace.h"
+#include <stdio.h>
+
+/*
+ * Replays Captures/button_presses.txt, writing every trace event to a file as "microseconds id payload" lines, for the
+ * Makefile to check the input-to-display and GPS sentence-to-time-set latencies with Tools/decode_trace.py --events.
+ * Built without CLOCK_VIRTUAL_MIN_FRAME_MICROS, so the display task runs at its real frame rate.
+ */
+
+const uint64_t END_MICROS = 30 * HARNESS_MICROS_PER_SECOND;
+
+static FILE *eventFile = NULL;
+
+static void writeEvent(uint8_t id, uint8_t payload) {
+  fprintf(eventFile, "%llu %u %u\n", static_cast<unsigned long long>(getClockTime()), id, payload);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s button_presses.bin events.txt\n", argv[0]);
+    return 2;
+  }
+  eventFile = fopen(argv[2], "w");
+  if (eventFile == NULL) {
+    fprintf(stderr, "Can't write %s\n", argv[2]);
+    return 2;
+  }
+  traceSetHook(writeEvent);
+  if (!startClock(argv[1])) {
+    return 2;
+  }
+
+  runClockUntil(END_MICROS);
+  HARNESS_CHECK(timekeeper.isTimeValid());
+  HARNESS_CHECK(taskScheduler.getTotalOverrunCount() == 0);
+  HARNESS_CHECK(fclose(eventFile) == 0);
+  return finishTest("TestReplayLatency");
+}
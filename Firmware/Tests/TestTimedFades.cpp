@@ -0,0 +1,87 @@
+#include "ClockHarness.h"
+#include "FrameBufferView.h"
+#include <stdio.h>
+
+/*
+ * Checks timed fades (FrameBufferView::enableTimedFade()): the values only depend on the time since the fade started,
+ * only the values which haven't reached the target are computed, and a view at its target isn't evaluated at all.
+ */
+
+const uint8_t VIEW_COUNT = 12;
+const uint32_t MICROS_PER_FADE_TICK = 1000;
+
+/**
+ * A timed fade view of its own buffer, recording the indices it modifies
+ */
+struct TimedFadeView {
+  uint8_t values[VIEW_COUNT];
+  FrameBufferDirtyRange<uint8_t> dirty;
+  FrameBufferView view;
+
+  TimedFadeView() : view(values, VIEW_COUNT, &dirty) {
+    memset(values, 0, sizeof(values));
+    view.enableTimedFade();
+    view.initializeFade(MICROS_PER_FADE_TICK, 0);
+    view.updateFade();
+    dirty.clear();
+  }
+};
+
+int main() {
+  // The values don't depend on how often the fade is updated
+  TimedFadeView often;
+  TimedFadeView never;
+  often.view.setValue(3, 200);
+  never.view.setValue(3, 200);
+  for (uint8_t i = 0; i < 100; ++i) {
+    advanceClockTime(MICROS_PER_FADE_TICK / 2);
+    often.view.updateFade();
+  }
+  never.view.updateFade();
+  HARNESS_CHECK(often.values[3] == 150);
+  HARNESS_CHECK(never.values[3] == 150);
+
+  // Only the fading value is computed and marked as modified
+  often.dirty.clear();
+  advanceClockTime(MICROS_PER_FADE_TICK);
+  often.view.updateFade();
+  HARNESS_CHECK(often.values[3] == 149);
+  HARNESS_CHECK(often.dirty.start == 3 && often.dirty.end == 4);
+
+  // Nothing is computed within a fade tick, or once every value has reached the target
+  often.dirty.clear();
+  advanceClockTime(MICROS_PER_FADE_TICK / 2);
+  often.view.updateFade();
+  HARNESS_CHECK(often.dirty.isEmpty());
+  advanceClockTime(150 * MICROS_PER_FADE_TICK);
+  often.view.updateFade();
+  HARNESS_CHECK(often.values[3] == 0);
+  often.dirty.clear();
+  advanceClockTime(10 * MICROS_PER_FADE_TICK);
+  often.view.updateFade();
+  HARNESS_CHECK(often.dirty.isEmpty());
+
+  // A write to an idle view only starts a fade of what it wrote
+  often.view.setValue(8, 100);
+  often.dirty.clear();
+  advanceClockTime(10 * MICROS_PER_FADE_TICK);
+  often.view.updateFade();
+  HARNESS_CHECK(often.values[8] == 90);
+  HARNESS_CHECK(often.dirty.start == 8 && often.dirty.end == 9);
+
+  // A write during a fade keeps the time already spent in the current fade tick
+  advanceClockTime(MICROS_PER_FADE_TICK / 2);
+  often.view.setValue(5, 100);
+  advanceClockTime(MICROS_PER_FADE_TICK * 3 / 5);
+  often.view.updateFade();
+  HARNESS_CHECK(often.values[8] == 89);
+  HARNESS_CHECK(often.values[5] == 99);
+
+  // Changing the target fades every value toward it
+  often.view.setFadeTarget(50);
+  advanceClockTime(60 * MICROS_PER_FADE_TICK);
+  often.view.updateFade();
+  HARNESS_CHECK(often.values[0] == 50 && often.values[5] == 50 && often.values[8] == 50 && often.values[11] == 50);
+
+  return finishTest("TestTimedFades");
+}
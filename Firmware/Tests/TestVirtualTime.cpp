@@ -0,0 +1,74 @@
+#include "ClockHarness.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Runs the clock for a simulated day (and a bit), checking that it keeps time from the GPS, sets it again once a day
+ * and meets every task deadline, and reports how fast the simulation ran.
+ * Built with CLOCK_VIRTUAL_MIN_FRAME_MICROS, so the display runs at about 60 frames per second.
+ */
+
+// The GPS time of the first sentence in Captures/daily_time_set.txt (2026-06-01 12:00:00 UTC), and when it's sent
+const uint32_t FIRST_GPS_UNIX_TIME = 1780315200;
+const uint64_t FIRST_GPS_MICROS = 2 * HARNESS_MICROS_PER_SECOND;
+
+// The second sentence is sent once the time set interval has passed
+const uint64_t SECOND_GPS_MICROS = 86410 * HARNESS_MICROS_PER_SECOND;
+
+// The clock sets the time once a whole sentence has arrived, so its seconds tick a little after the GPS ones: the time
+// is checked half way between ticks
+const uint64_t END_MICROS = SECOND_GPS_MICROS + 60 * HARNESS_MICROS_PER_SECOND + HARNESS_MICROS_PER_SECOND / 2;
+
+static uint16_t gpsTimeSetCount = 0;
+
+static void countTimeSets(uint8_t id, uint8_t /* payload */) {
+  if (id == TRACE_EVENT_GPS_TIME_SET) {
+    ++gpsTimeSetCount;
+  }
+}
+
+/**
+ * Gets the local time the clock should show at the given virtual time (the GPS time plus the time zone offset)
+ */
+static uint32_t getExpectedTime(uint64_t microseconds) {
+  int32_t timezoneSeconds = (options.getTimezone() + (options.getDST() ? 1 : 0)) * 3600L;
+  return FIRST_GPS_UNIX_TIME + timezoneSeconds + static_cast<uint32_t>((microseconds - FIRST_GPS_MICROS) / HARNESS_MICROS_PER_SECOND);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s daily_time_set.bin\n", argv[0]);
+    return 2;
+  }
+  traceSetHook(countTimeSets);
+  clock_t startClockTicks = clock();
+  if (!startClock(argv[1])) {
+    return 2;
+  }
+
+  // No time until the GPS sends one
+  runClockUntil(FIRST_GPS_MICROS - HARNESS_MICROS_PER_SECOND);
+  HARNESS_CHECK(!timekeeper.isTimeValid());
+
+  // The clock keeps time from the GPS until the next time set is due
+  runClockUntil(FIRST_GPS_MICROS + 10 * HARNESS_MICROS_PER_SECOND);
+  HARNESS_CHECK(timekeeper.isTimeValid());
+  HARNESS_CHECK(gpsTimeSetCount == 1);
+  for (uint64_t hour = 1; hour <= 24; ++hour) {
+    runClockUntil(FIRST_GPS_MICROS + hour * 3600 * HARNESS_MICROS_PER_SECOND - HARNESS_MICROS_PER_SECOND / 2);
+    HARNESS_CHECK(timekeeper.getTime().unixtime() == getExpectedTime(getClockTime()));
+  }
+
+  // The next day's sentence sets it again
+  runClockUntil(END_MICROS);
+  HARNESS_CHECK(gpsTimeSetCount == 2);
+  HARNESS_CHECK(!timekeeper.isTimeSetPending());
+  HARNESS_CHECK(timekeeper.getTime().unixtime() == getExpectedTime(getClockTime()));
+  HARNESS_CHECK(taskScheduler.getTotalOverrunCount() == 0);
+
+  double wallSeconds = static_cast<double>(clock() - startClockTicks) / CLOCKS_PER_SEC;
+  double simulatedSeconds = static_cast<double>(getClockTime()) / HARNESS_MICROS_PER_SECOND;
+  printf("Simulated %.0f s in %.1f s (%.0f simulated seconds per second)\n", simulatedSeconds, wallSeconds, simulatedSeconds / wallSeconds);
+  return finishTest("TestVirtualTime");
+}
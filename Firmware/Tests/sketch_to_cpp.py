@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+"""
+Turns the sketch into a C++ source file the way the Arduino builder does: Arduino.h is included first, and a prototype
+of every function is declared after the sketch's own includes (so functions can be called before they're defined).
+
+Usage: sketch_to_cpp.py sketch.ino output.cpp
+"""
+
+import re
+import sys
+
+FUNCTION = re.compile(r'^(?!(?:if|for|while|switch|return|else|do|ISR)\b)([A-Za-z_][\w \t*&:<>,]*?\b\w+\s*\([^;{}]*\))\s*\{\s*$')
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip())
+    with open(sys.argv[1]) as sketch:
+        lines = sketch.read().split('\n')
+
+    prototypes = [match.group(1) + ';' for match in (FUNCTION.match(line) for line in lines) if match]
+    last_include = max([i for i, line in enumerate(lines) if line.startswith('#include')] or [-1])
+    output = ['#include "Arduino.h"', '#line 1 "%s"' % sys.argv[1]] + lines[:last_include + 1] + prototypes
+    output += ['#line %d "%s"' % (last_include + 2, sys.argv[1])] + lines[last_include + 1:]
+    with open(sys.argv[2], 'w') as cpp:
+        cpp.write('\n'.join(output))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+Decodes a Faux Analog Clock trace log (see Firmware/Faux_Analog_Clock/Trace.h) into a timeline.
+
+The log can be given either as a raw memory dump of the `traceLog` symbol (e.g. from simavr), or as text
+containing the hex bytes shown by the "tr" utility (whitespace separated; "--" markers are ignored).
+A virtual time build can also record every event through traceSetHook() as text lines of
+"<microseconds> <event id> <payload>", which --events reads; such a log is not limited to TRACE_LOG_LENGTH events.
+
+--latency reports the time from each replayed button change (see InputReplay.h) until the menu has seen it, the face
+task has drawn it and the next frame has been swapped in, and from the start of each replayed GPS sentence until the next GPS time set. --max-input-latency and --max-gps-latency (milliseconds) exit with status 1 if any is exceeded.
+
+Usage: decode_trace.py [--hex | --events] [--latency] [--max-input-latency MS] [--max-gps-latency MS] <file>
+"""
+
+import os
+import re
+import struct
+import sys
+
+SKETCH_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Faux_Analog_Clock')
+TRACE_MAGIC = 0x7ace
+TIMESTAMP_MICROSECONDS = 16
+TIMESTAMP_WRAP = 1 << 16
+
+
+def read_event_names():
+    """Reads the event IDs and names from Trace.h"""
+    names = {}
+    with open(os.path.join(SKETCH_DIR, 'Trace.h')) as header:
+        for match in re.finditer(r'const uint8_t TRACE_EVENT_(\w+) = (\d+);', header.read()):
+            names[int(match.group(2))] = match.group(1)
+    return names
+
+
+def read_task_names():
+    """Reads the task names from the CLOCK_TASKS table, in order"""
+    with open(os.path.join(SKETCH_DIR, 'Faux_Analog_Clock.ino')) as sketch:
+        table = re.search(r'ScheduledTask CLOCK_TASKS\[\] = \{(.*?)\};', sketch.read(), re.S)
+    return re.findall(r'\{\s*run(\w+)Task\s*,', table.group(1)) if table else []
+
+
+def read_log(path, is_hex):
+    if is_hex:
+        with open(path) as text:
+            return bytes(int(token, 16) for token in text.read().split() if token != '--')
+    with open(path, 'rb') as binary:
+        return binary.read()
+
+
+def decode(data):
+    magic, head, count = struct.unpack_from('<HBB', data, 0)
+    if magic != TRACE_MAGIC:
+        sys.exit('Not a trace log (bad magic 0x%04x)' % magic)
+    length = (len(data) - 4) // 4
+    if length == 0 or head >= length or count > length:
+        sys.exit('Truncated or corrupt trace log')
+
+    # Oldest event first
+    events = []
+    for i in range(count):
+        index = (head - count + i) % length
+        events.append(struct.unpack_from('<HBB', data, 4 + index * 4))
+    return events
+
+
+def read_event_lines(path):
+    """Reads a full event log written by a virtual time build, as (microseconds, event id, payload) tuples"""
+    events = []
+    with open(path) as text:
+        for line in text:
+            fields = line.split()
+            if len(fields) == 3:
+                events.append((int(fields[0]), int(fields[1]), int(fields[2])))
+    return events
+
+
+def unwrap(events):
+    """Converts device log events into (microseconds, event id, payload) tuples"""
+    # Timestamps wrap every 1.05 s, so gaps longer than that between consecutive events can't be recovered
+    result = []
+    time = 0
+    last_timestamp = None
+    for timestamp, event_id, payload in events:
+        if last_timestamp is not None:
+            time += (timestamp - last_timestamp) % TIMESTAMP_WRAP
+        last_timestamp = timestamp
+        result.append((time * TIMESTAMP_MICROSECONDS, event_id, payload))
+    return result
+
+
+def measure_latencies(events, event_names, task_names, stages):
+    """
+    Gets the time in microseconds from each event named stages[0] until events named stages[1], stages[2], ... have
+    followed it in that order (task events can be named with their task, e.g. "TASK_END:Face"). A start event that is followed by another one before reaching stages[1] is replaced by it
+    (e.g. a replayed button state that doesn't change the buttons the menu reads).
+    """
+    latencies = []
+    pending = [[] for _ in stages[1:]]
+    for time, event_id, payload in events:
+        name = event_names.get(event_id)
+        if name is not None and name.startswith('TASK_') and payload < len(task_names):
+            name += ':' + task_names[payload]
+        if name == stages[0]:
+            pending[0] = [time]
+        for stage in range(len(stages) - 1, 0, -1):
+            if name == stages[stage] and pending[stage - 1]:
+                if stage == len(stages) - 1:
+                    latencies += [time - start for start in pending[stage - 1]]
+                else:
+                    pending[stage] += pending[stage - 1]
+                pending[stage - 1] = []
+    return latencies
+
+
+def report_latencies(label, latencies, limit_ms):
+    if not latencies:
+        print('%s: no samples' % label)
+        return True
+    worst = max(latencies) / 1000.0
+    print('%s: %d samples, mean %.3f ms, max %.3f ms' % (label, len(latencies),
+                                                        sum(latencies) / 1000.0 / len(latencies), worst))
+    if limit_ms is not None and worst > limit_ms:
+        print('%s: FAILED (limit %.3f ms)' % (label, limit_ms))
+        return False
+    return True
+
+
+def main():
+    args = sys.argv[1:]
+    is_hex = '--hex' in args
+    is_events = '--events' in args
+    show_latency = '--latency' in args
+    limits = {}
+    for option in ('--max-input-latency', '--max-gps-latency'):
+        if option in args:
+            index = args.index(option)
+            limits[option] = float(args[index + 1])
+            del args[index:index + 2]
+            show_latency = True
+    args = [arg for arg in args if arg not in ('--hex', '--events', '--latency')]
+    if len(args) != 1 or (is_hex and is_events):
+        sys.exit(__doc__.strip())
+
+    event_names = read_event_names()
+    task_names = read_task_names()
+    events = read_event_lines(args[0]) if is_events else unwrap(decode(read_log(args[0], is_hex)))
+
+    if show_latency:
+        input_ok = report_latencies('Input to display', measure_latencies(events, event_names, task_names, ('REPLAY_BUTTONS', 'BUTTON_CHANGE', 'TASK_END:Face', 'FRAME_SWAP')),
+                                    limits.get('--max-input-latency'))
+        gps_ok = report_latencies('NMEA to time set', measure_latencies(events, event_names, task_names, ('REPLAY_GPS', 'NMEA_RECEIVED', 'GPS_TIME_SET')),
+                                  limits.get('--max-gps-latency'))
+        sys.exit(0 if input_ok and gps_ok else 1)
+
+    last_time = None
+    for time, event_id, payload in events:
+        delta = 0 if last_time is None else time - last_time
+        last_time = time
+
+        name = event_names.get(event_id, 'UNKNOWN_%d' % event_id)
+        if name.startswith('TASK_') or name == 'DEADLINE_OVERRUN':
+            detail = task_names[payload] if payload < len(task_names) else 'task %d' % payload
+        else:
+            detail = str(payload)
+        print('%10.3f ms  (+%8.3f)  %-22s %s' % (time / 1000.0, delta / 1000.0, name, detail))
+
+
+if __name__ == '__main__':
+    main()
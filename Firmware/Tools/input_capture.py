@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Converts Faux Analog Clock input captures (see Firmware/Faux_Analog_Clock/InputReplay.h) between text and the compact binary format.
+
+Text format, one event per line (blank lines and lines starting with # are ignored):
+  <milliseconds> B <button port state, hex>   e.g. "1500 B 20" (Select pressed: its PB4 bit is low)
+  <milliseconds> G <NMEA sentence>            e.g. "2000 G $GPRMC,...*6A" (CR LF is appended)
+Times are absolute (milliseconds since the start of the capture) and must not decrease.
+
+Usage:
+  input_capture.py encode capture.txt capture.bin
+  input_capture.py decode capture.bin
+"""
+
+import sys
+
+MAGIC = b'FACI'
+VERSION = 1
+EVENT_BUTTONS = 1
+EVENT_GPS = 2
+MAX_GPS_BYTES = 255
+
+
+def varint(value):
+    result = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        result.append(byte | (0x80 if value else 0))
+        if not value:
+            return bytes(result)
+
+
+def encode(lines):
+    output = bytearray(MAGIC + bytes([VERSION]))
+    last_time = 0
+    for number, line in enumerate(lines, 1):
+        line = line.rstrip('\r\n')
+        if not line.strip() or line.startswith('#'):
+            continue
+        time_text, kind, value = line.split(' ', 2)
+        time = int(time_text)
+        if time < last_time:
+            sys.exit('line %d: time goes backwards' % number)
+
+        if kind == 'B':
+            payload = bytes([EVENT_BUTTONS, int(value, 16)])
+        elif kind == 'G':
+            data = (value + '\r\n').encode('ascii')
+            if len(data) > MAX_GPS_BYTES:
+                sys.exit('line %d: sentence longer than %d bytes' % (number, MAX_GPS_BYTES))
+            payload = bytes([EVENT_GPS, len(data)]) + data
+        else:
+            sys.exit('line %d: unknown event type %r' % (number, kind))
+        output += varint(time - last_time) + payload
+        last_time = time
+    return bytes(output)
+
+
+def decode(data):
+    if data[:4] != MAGIC or data[4] != VERSION:
+        sys.exit('Not an input capture')
+    position, time, lines = 5, 0, []
+    while position < len(data):
+        delta, shift = 0, 0
+        while True:
+            byte = data[position]
+            position += 1
+            delta |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        time += delta
+        kind = data[position]
+        if kind == EVENT_BUTTONS:
+            lines.append('%d B %02x' % (time, data[position + 1]))
+            position += 2
+        elif kind == EVENT_GPS:
+            count = data[position + 1]
+            lines.append('%d G %s' % (time, data[position + 2:position + 2 + count].decode('ascii').rstrip('\r\n')))
+            position += 2 + count
+        else:
+            sys.exit('Unknown event type %d at byte %d' % (kind, position))
+    return lines
+
+
+def main():
+    if len(sys.argv) == 4 and sys.argv[1] == 'encode':
+        with open(sys.argv[2]) as text:
+            data = encode(text.readlines())
+        with open(sys.argv[3], 'wb') as binary:
+            binary.write(data)
+    elif len(sys.argv) == 3 and sys.argv[1] == 'decode':
+        with open(sys.argv[2], 'rb') as binary:
+            print('\n'.join(decode(binary.read())))
+    else:
+        sys.exit(__doc__.strip())
+
+
+if __name__ == '__main__':
+    main()
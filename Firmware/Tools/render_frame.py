@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+Renders Faux Analog Clock frame buffers (CLOCK_DISPLAY_LED_COUNT LED values, in display order) into PNG images,
+laid out like the clock using the CLOCK_*_OFFSET constants from ClockDisplay.h.
+
+A frame buffer can be dumped from a simulator such as simavr (the front buffer of `clockDisplay`).
+Given several dumps, the frames are written as one animated PNG.
+Given a golden image, the rendered frame is compared with it, and the exit status is 1 if they differ.
+
+Usage:
+  render_frame.py [--offset N] [--delay MS] -o output.png dump [dump...]
+  render_frame.py [--offset N] [--tolerance T] --compare golden.png dump
+"""
+
+import argparse
+import math
+import os
+import re
+import struct
+import sys
+import zlib
+
+SKETCH_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Faux_Analog_Clock')
+IMAGE_SIZE = 400
+LED_RADIUS = 6
+BACKGROUND = (16, 16, 16)
+UNLIT = (40, 40, 40)
+
+
+def read_layout():
+    """Reads the LED count and ring offsets from ClockDisplay.h"""
+    with open(os.path.join(SKETCH_DIR, 'ClockDisplay.h')) as header:
+        constants = dict((name, int(value)) for name, value in re.findall(r'const \w+ (CLOCK_\w+) = (\d+);', header.read()))
+    return constants
+
+
+def led_positions(constants):
+    """Gets the (x, y, kind) position of every LED, in display order (units of half the image size, centered)"""
+    def ring(count, radius):
+        # Clockwise from 12 o'clock
+        return [(radius * math.sin(2 * math.pi * i / count), -radius * math.cos(2 * math.pi * i / count), 'dot') for i in range(count)]
+
+    def pendulum(count):
+        return [(-0.45 + 0.9 * i / (count - 1), 0.35, 'dot') for i in range(count)]
+
+    def seven_segment(center_x):
+        # Segments A..G (see SevenSegment.h)
+        w, h, y = 0.07, 0.09, -0.3
+        return [(center_x, y - h, 'h'), (center_x + w, y - h / 2, 'v'), (center_x + w, y + h / 2, 'v'), (center_x, y + h, 'h'),
+                (center_x - w, y + h / 2, 'v'), (center_x - w, y - h / 2, 'v'), (center_x, y, 'h')]
+
+    positions = (ring(60, 0.88) + ring(60, 0.78) + ring(12, 0.66) + pendulum(12) + ring(12, 0.5) + ring(12, 0.97)
+                 + seven_segment(-0.1) + seven_segment(0.1))
+    order = ['CLOCK_SECONDS_OFFSET', 'CLOCK_MINUTES_OFFSET', 'CLOCK_HOURS_OFFSET', 'CLOCK_PENDULUM_OFFSET',
+             'CLOCK_FACE_INNER_OFFSET', 'CLOCK_FACE_OUTER_OFFSET', 'CLOCK_7SEG_LEFT_OFFSET', 'CLOCK_7SEG_RIGHT_OFFSET']
+    sizes = [60, 60, 12, 12, 12, 12, 7, 7]
+
+    # Place each group at its offset, so the layout follows ClockDisplay.h
+    result = [None] * constants['CLOCK_DISPLAY_LED_COUNT']
+    start = 0
+    for name, size in zip(order, sizes):
+        for i in range(size):
+            result[constants[name] + i] = positions[start + i]
+        start += size
+    return result
+
+
+def render(values, positions):
+    pixels = [list(BACKGROUND) * IMAGE_SIZE for _ in range(IMAGE_SIZE)]
+    scale = IMAGE_SIZE / 2.0
+    for value, (x, y, kind) in zip(values, positions):
+        color = tuple(min(255, c + (value * (255 - c)) // 255) for c in UNLIT) if value > 0 else UNLIT
+        cx, cy = int(scale + x * scale), int(scale + y * scale)
+        rx, ry = {'dot': (LED_RADIUS, LED_RADIUS), 'h': (3 * LED_RADIUS // 2, LED_RADIUS // 2), 'v': (LED_RADIUS // 2, 3 * LED_RADIUS // 2)}[kind]
+        for py in range(max(0, cy - ry), min(IMAGE_SIZE, cy + ry + 1)):
+            for px in range(max(0, cx - rx), min(IMAGE_SIZE, cx + rx + 1)):
+                if kind != 'dot' or (px - cx) ** 2 + (py - cy) ** 2 <= LED_RADIUS ** 2:
+                    pixels[py][px * 3:px * 3 + 3] = color
+    return pixels
+
+
+def chunk(kind, data):
+    return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data) & 0xffffffff)
+
+
+def compress(pixels):
+    return zlib.compress(b''.join(b'\0' + bytes(row) for row in pixels), 9)
+
+
+def write_png(path, frames, delay_ms):
+    data = b'\x89PNG\r\n\x1a\n' + chunk(b'IHDR', struct.pack('>IIBBBBB', IMAGE_SIZE, IMAGE_SIZE, 8, 2, 0, 0, 0))
+    if len(frames) == 1:
+        data += chunk(b'IDAT', compress(frames[0]))
+    else:
+        # Animated PNG
+        data += chunk(b'acTL', struct.pack('>II', len(frames), 0))
+        sequence = 0
+        for i, frame in enumerate(frames):
+            data += chunk(b'fcTL', struct.pack('>IIIIIHHBB', sequence, IMAGE_SIZE, IMAGE_SIZE, 0, 0, delay_ms, 1000, 0, 0))
+            sequence += 1
+            if i == 0:
+                data += chunk(b'IDAT', compress(frame))
+            else:
+                data += chunk(b'fdAT', struct.pack('>I', sequence) + compress(frame))
+                sequence += 1
+    data += chunk(b'IEND', b'')
+    with open(path, 'wb') as output:
+        output.write(data)
+
+
+def read_png(path):
+    """Reads the first frame of an 8-bit RGB PNG (as written by this tool)"""
+    with open(path, 'rb') as image:
+        data = image.read()
+    position, compressed, width = 8, b'', 0
+    while position < len(data):
+        length, kind = struct.unpack_from('>I4s', data, position)
+        body = data[position + 8:position + 8 + length]
+        if kind == b'IHDR':
+            width, height, depth, color_type = struct.unpack_from('>IIBB', body)
+            if depth != 8 or color_type != 2:
+                sys.exit('%s: only 8-bit RGB images are supported' % path)
+        elif kind == b'IDAT':
+            compressed += body
+        position += 12 + length
+    raw = zlib.decompress(compressed)
+    stride = width * 3
+    rows, previous = [], [0] * stride
+    for y in range(len(raw) // (stride + 1)):
+        filter_type, line = raw[y * (stride + 1)], list(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for x in range(stride):
+            left = line[x - 3] if x >= 3 else 0
+            up = previous[x]
+            up_left = previous[x - 3] if x >= 3 else 0
+            if filter_type == 1:
+                line[x] = (line[x] + left) & 0xff
+            elif filter_type == 2:
+                line[x] = (line[x] + up) & 0xff
+            elif filter_type == 3:
+                line[x] = (line[x] + (left + up) // 2) & 0xff
+            elif filter_type == 4:
+                p = left + up - up_left
+                predictor = min((abs(p - left), 0, left), (abs(p - up), 1, up), (abs(p - up_left), 2, up_left))[2]
+                line[x] = (line[x] + predictor) & 0xff
+        rows.append(line)
+        previous = line
+    return rows
+
+
+def read_frame(path, offset, count):
+    with open(path, 'rb') as dump:
+        data = dump.read()[offset:offset + count]
+    if len(data) < count:
+        sys.exit('%s: expected %d LED values at offset %d' % (path, count, offset))
+    return list(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Renders clock frame buffer dumps into PNG images.')
+    parser.add_argument('dumps', nargs='+', help='frame buffer dumps (raw bytes)')
+    parser.add_argument('-o', '--output', help='PNG to write (animated if several dumps are given)')
+    parser.add_argument('--offset', type=int, default=0, help='offset of the frame buffer within each dump')
+    parser.add_argument('--delay', type=int, default=100, help='animation frame delay in milliseconds')
+    parser.add_argument('--compare', help='golden PNG to compare the (first) rendered frame with')
+    parser.add_argument('--tolerance', type=int, default=0, help='largest allowed per-channel difference when comparing')
+    args = parser.parse_args()
+    if not args.output and not args.compare:
+        parser.error('nothing to do (give --output and/or --compare)')
+
+    constants = read_layout()
+    positions = led_positions(constants)
+    frames = [render(read_frame(path, args.offset, constants['CLOCK_DISPLAY_LED_COUNT']), positions) for path in args.dumps]
+    if args.output:
+        write_png(args.output, frames, args.delay)
+
+    if args.compare:
+        golden = read_png(args.compare)
+        differences = sum(1 for row, golden_row in zip(frames[0], golden) for value, golden_value in zip(row, golden_row)
+                          if abs(value - golden_value) > args.tolerance)
+        if len(golden) != IMAGE_SIZE or differences > 0:
+            print('%s differs from %s (%d channel values)' % (args.dumps[0], args.compare, differences))
+            sys.exit(1)
+        print('%s matches %s' % (args.dumps[0], args.compare))
+
+
+if __name__ == '__main__':
+    main()